@@ -0,0 +1,26 @@
+#pragma once
+#include "swiftwire/histogram.hpp"
+#include "swiftwire/server.hpp"
+#include <cstdio>
+
+namespace swiftwire::bench {
+
+// Echo service used by the benchmark tools: REQUEST(0x10, p) -> RESPONSE(0x90, p)
+inline constexpr uint8_t kEcho = 0x10;
+inline constexpr uint8_t kEchoReply = 0x90;
+
+inline void install_echo(AsyncServer& server) {
+    server.router().on(kEcho, [](MessageContext& ctx, const Message& msg) {
+        ctx.reply(kEchoReply, msg.data, msg.size);
+    });
+}
+
+// "  <label> us: p50=… p90=… … max=… mean=…"
+inline void print_latency(const char* label, const Histogram& h) {
+    auto us = [](uint64_t ns) { return double(ns) / 1000.0; };
+    std::printf("  %s us: p50=%.1f p90=%.1f p99=%.1f p99.9=%.1f p99.99=%.1f max=%.1f mean=%.1f\n",
+                label, us(h.percentile(50)), us(h.percentile(90)), us(h.percentile(99)),
+                us(h.percentile(99.9)), us(h.percentile(99.99)), us(h.max()), h.mean() / 1000.0);
+}
+
+} // namespace swiftwire::bench
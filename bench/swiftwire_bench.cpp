@@ -0,0 +1,188 @@
+// Closed-loop loopback benchmark: an in-process AsyncServer echoes correlated
+// requests issued by AsyncClients that each keep `pipeline` requests in flight.
+//
+//   swiftwire_bench --connections=64 --pipeline=16 --sizes=16,256,4096
+//                   --server-threads=2 --client-threads=2 --duration=5 --warmup=1
+#include "bench_common.hpp"
+#include "swiftwire/client.hpp"
+#include "swiftwire/stage_metrics.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+using swiftwire::bench::kEcho;
+using swiftwire::bench::kEchoReply;
+
+struct Options {
+    std::size_t connections = 16;
+    std::size_t pipeline = 8;
+    std::vector<std::size_t> sizes{64};
+    std::size_t server_threads = 2;
+    std::size_t client_threads = 2;
+    double duration = 5.0;
+    double warmup = 1.0;
+    bool stage_metrics = false;
+};
+
+bool parse_option(Options& o, const std::string& arg) {
+    auto eq = arg.find('=');
+    if (arg.rfind("--", 0) != 0 || eq == std::string::npos) return false;
+    const std::string key = arg.substr(2, eq - 2), val = arg.substr(eq + 1);
+    if (key == "connections") o.connections = std::stoul(val);
+    else if (key == "pipeline") o.pipeline = std::stoul(val);
+    else if (key == "server-threads") o.server_threads = std::stoul(val);
+    else if (key == "client-threads") o.client_threads = std::stoul(val);
+    else if (key == "duration") o.duration = std::stod(val);
+    else if (key == "warmup") o.warmup = std::stod(val);
+    else if (key == "stage-metrics") o.stage_metrics = (val == "1" || val == "true");
+    else if (key == "sizes") {
+        o.sizes.clear();
+        std::stringstream ss(val);
+        for (std::string item; std::getline(ss, item, ',');) o.sizes.push_back(std::stoul(item));
+    } else return false;
+    return true;
+}
+
+// Shared by all connections driven from one client thread
+struct Worker {
+    boost::asio::io_context io{1};
+    swiftwire::Histogram latency;
+    uint64_t frames = 0;
+    std::atomic<bool>* measuring = nullptr;
+    std::atomic<bool>* stopping = nullptr;
+};
+
+class Connection : public std::enable_shared_from_this<Connection> {
+public:
+    Connection(Worker& w, std::size_t payload) : w_(w), payload_(payload, 'x'),
+        client_(std::make_shared<swiftwire::AsyncClient>(w.io)) {}
+
+    void start(const std::string& port, std::size_t pipeline) {
+        auto self = shared_from_this();
+        client_->async_connect("127.0.0.1", port, std::chrono::seconds(5),
+            [self, pipeline](auto ec) {
+                if (ec) { std::cerr << "connect: " << ec.message() << "\n"; return; }
+                for (std::size_t i = 0; i < pipeline; ++i) self->issue();
+            });
+    }
+
+private:
+    void issue() {
+        if (w_.stopping->load(std::memory_order_relaxed)) {
+            if (client_->outstanding() == 0) client_->close();
+            return;
+        }
+        auto self = shared_from_this();
+        const auto sent = clock_type::now();
+        client_->async_request(kEcho, payload_, std::chrono::seconds(10),
+            [self, sent](auto ec, uint8_t type, std::string_view) {
+                if (ec || type != kEchoReply) {
+                    if (ec != boost::asio::error::operation_aborted)
+                        std::cerr << "request: " << ec.message() << "\n";
+                    return;
+                }
+                if (self->w_.measuring->load(std::memory_order_relaxed)) {
+                    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - sent);
+                    self->w_.latency.record(static_cast<uint64_t>(ns.count()));
+                    ++self->w_.frames;
+                }
+                self->issue();
+            });
+    }
+
+    Worker& w_;
+    std::string payload_;
+    swiftwire::AsyncClientPtr client_;
+};
+
+void run_one(const Options& o, std::size_t size) {
+    swiftwire::ServerConfig cfg;
+    cfg.threads = o.server_threads;
+    cfg.stage_metrics = o.stage_metrics;
+    swiftwire::AsyncServer server({boost::asio::ip::make_address("127.0.0.1"), 0}, cfg);
+    swiftwire::bench::install_echo(server);
+    server.run();
+    const std::string port = std::to_string(server.local_endpoint().port());
+
+    std::atomic<bool> measuring{false}, stopping{false};
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (std::size_t i = 0; i < std::max<std::size_t>(1, o.client_threads); ++i) {
+        workers.push_back(std::make_unique<Worker>());
+        workers.back()->measuring = &measuring;
+        workers.back()->stopping = &stopping;
+    }
+    for (std::size_t c = 0; c < o.connections; ++c) {
+        auto& w = *workers[c % workers.size()];
+        std::make_shared<Connection>(w, size)->start(port, o.pipeline);
+    }
+
+    std::vector<std::thread> threads;
+    for (auto& w : workers) threads.emplace_back([&w] { w->io.run(); });
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(o.warmup));
+    const auto t0 = clock_type::now();
+    measuring = true;
+    std::this_thread::sleep_for(std::chrono::duration<double>(o.duration));
+    measuring = false;
+    const double secs = std::chrono::duration<double>(clock_type::now() - t0).count();
+    stopping = true;
+    for (auto& t : threads) t.join();
+    server.stop();
+    server.join();
+
+    swiftwire::Histogram total;
+    uint64_t frames = 0;
+    for (auto& w : workers) {
+        total.merge(w->latency);
+        frames += w->frames;
+    }
+    const double fps = double(frames) / secs;
+    std::printf("size=%zuB conns=%zu pipeline=%zu server_threads=%zu client_threads=%zu backend=%s\n",
+                size, o.connections, o.pipeline, o.server_threads, o.client_threads, swiftwire::io_backend);
+    std::printf("  throughput: %.0f req/s  %.1f MB/s each way\n", fps, fps * double(size + 10) / 1e6);
+    swiftwire::bench::print_latency("latency", total);
+
+    if (o.stage_metrics) {
+        // Server threads have exited, so the per-thread sets are quiescent
+        swiftwire::StageHistograms stages;
+        swiftwire::collect_stage_metrics(stages);
+        swiftwire::reset_stage_metrics();
+        using swiftwire::Stage;
+        swiftwire::bench::print_latency("read->dispatch   ", stages[Stage::read_to_dispatch]);
+        swiftwire::bench::print_latency("dispatch->enqueue", stages[Stage::dispatch_to_enqueue]);
+        swiftwire::bench::print_latency("enqueue->written ", stages[Stage::enqueue_to_write]);
+        const auto& depth = stages[Stage::queue_depth];
+        std::printf("  queue depth at enqueue: p50=%llu p99=%llu max=%llu\n",
+                    (unsigned long long)depth.percentile(50), (unsigned long long)depth.percentile(99),
+                    (unsigned long long)depth.max());
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options o;
+    for (int i = 1; i < argc; ++i) {
+        if (!parse_option(o, argv[i])) {
+            std::cerr << "usage: swiftwire_bench [--connections=N] [--pipeline=N] [--sizes=a,b,...]\n"
+                         "                       [--server-threads=N] [--client-threads=N]\n"
+                         "                       [--duration=SEC] [--warmup=SEC] [--stage-metrics=1]\n";
+            return 1;
+        }
+    }
+    try {
+        for (auto size : o.sizes) run_one(o, size);
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
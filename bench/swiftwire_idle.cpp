@@ -0,0 +1,148 @@
+// Idle-connection footprint: opens `connections` plain sockets to an
+// in-process AsyncServer, completes a HELLO on each and leaves them idle, then
+// reports the server's heap growth per connection (glibc mallinfo2) and the
+// process RSS growth, with and without ServerConfig::low_footprint.
+//
+//   swiftwire_idle --connections=10000 --server-threads=2
+//
+// Client sockets are raw fds, so heap growth is the server's alone; RSS also
+// excludes kernel socket buffers. Each connection uses two descriptors.
+#include "swiftwire/protocol.hpp"
+#include "swiftwire/server.hpp"
+#include <arpa/inet.h>
+#include <malloc.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::size_t connections = 10000;
+    std::size_t server_threads = 2;
+};
+
+bool parse_option(Options& o, const std::string& arg) {
+    auto eq = arg.find('=');
+    if (arg.rfind("--", 0) != 0 || eq == std::string::npos) return false;
+    const std::string key = arg.substr(2, eq - 2), val = arg.substr(eq + 1);
+    if (key == "connections") o.connections = std::stoul(val);
+    else if (key == "server-threads") o.server_threads = std::stoul(val);
+    else return false;
+    return true;
+}
+
+std::size_t heap_in_use() {
+    const auto mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+}
+
+std::size_t rss_bytes() {
+    std::ifstream statm("/proc/self/statm");
+    std::size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+}
+
+void raise_fd_limit(std::size_t wanted) {
+    rlimit rl{};
+    if (getrlimit(RLIMIT_NOFILE, &rl) != 0 || rl.rlim_cur >= wanted) return;
+    rl.rlim_cur = std::min<rlim_t>(wanted, rl.rlim_max);
+    setrlimit(RLIMIT_NOFILE, &rl);
+}
+
+// Blocking connect + HELLO; returns the fd once the HELLO_ACK has arrived
+int connect_idle(uint16_t port, uint64_t id) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    char hello[4 + 1 + 8];
+    swiftwire::proto::write_u32be(hello, 1 + 8);
+    hello[4] = static_cast<char>(swiftwire::proto::MSG_HELLO);
+    swiftwire::proto::write_u64be(hello + 5, id);
+    char ack[4 + 1 + 8 + 1];
+    std::size_t got = 0;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) != 0 ||
+        ::send(fd, hello, sizeof hello, 0) != static_cast<ssize_t>(sizeof hello)) {
+        ::close(fd);
+        return -1;
+    }
+    while (got < sizeof ack) {
+        const ssize_t n = ::recv(fd, ack + got, sizeof ack - got, 0);
+        if (n <= 0) {
+            ::close(fd);
+            return -1;
+        }
+        got += static_cast<std::size_t>(n);
+    }
+    return fd;
+}
+
+void run_one(const Options& o, bool low_footprint) {
+    swiftwire::ServerConfig cfg;
+    cfg.threads = o.server_threads;
+    cfg.idle_timeout = std::chrono::seconds(3600);
+    cfg.low_footprint = low_footprint;
+    swiftwire::AsyncServer server({boost::asio::ip::make_address("127.0.0.1"), 0}, cfg);
+    server.run();
+    const uint16_t port = server.local_endpoint().port();
+
+    // Warm up the shard threads' pools and the allocator before the baseline
+    for (int fd = connect_idle(port, 0); fd >= 0; fd = -1) ::close(fd);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    const std::size_t heap0 = heap_in_use(), rss0 = rss_bytes();
+
+    std::vector<int> fds;
+    fds.reserve(o.connections);
+    for (std::size_t i = 0; i < o.connections; ++i) {
+        const int fd = connect_idle(port, i + 1);
+        if (fd < 0) {
+            std::cerr << "connect " << i << " failed (fd limit?)\n";
+            break;
+        }
+        fds.push_back(fd);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200)); // let the last writes retire
+    const std::size_t heap1 = heap_in_use(), rss1 = rss_bytes();
+
+    const double n = static_cast<double>(std::max<std::size_t>(1, fds.size()));
+    std::printf("low_footprint=%d conns=%zu server_threads=%zu backend=%s\n", low_footprint ? 1 : 0,
+                fds.size(), o.server_threads, swiftwire::io_backend);
+    std::printf("  heap: %.0f B/conn  rss: %.0f B/conn\n", double(heap1 - heap0) / n,
+                double(rss1 > rss0 ? rss1 - rss0 : 0) / n);
+
+    for (int fd : fds) ::close(fd);
+    server.stop();
+    server.join();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options o;
+    for (int i = 1; i < argc; ++i) {
+        if (!parse_option(o, argv[i])) {
+            std::cerr << "usage: swiftwire_idle [--connections=N] [--server-threads=N]\n";
+            return 1;
+        }
+    }
+    raise_fd_limit(2 * o.connections + 64);
+    try {
+        run_one(o, false);
+        run_one(o, true);
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
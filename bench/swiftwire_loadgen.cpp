@@ -0,0 +1,249 @@
+// Open-loop load generator: issues correlated requests at a fixed target rate
+// no matter how fast responses come back. Every request has an intended send
+// time on a fixed schedule; latency measured from that instant (rather than
+// from when the request actually left) is corrected for coordinated omission.
+//
+//   swiftwire_loadgen --rate=50000 --connections=32 --threads=2 --size=64 --duration=10
+//   swiftwire_loadgen --host=10.0.0.5 --port=9000 --type=16 --rate=20000
+//
+// Without --host an in-process echo server is started on 127.0.0.1.
+#include "bench_common.hpp"
+#include "swiftwire/client.hpp"
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+struct Options {
+    std::string host;
+    std::string port = "9000";
+    uint8_t type = swiftwire::bench::kEcho;
+    double rate = 10000;             // requests/s, all threads together
+    std::size_t connections = 16;
+    std::size_t threads = 2;
+    std::size_t size = 64;
+    std::size_t server_threads = 2;  // in-process server only
+    double duration = 10.0;
+    double warmup = 1.0;
+    std::chrono::milliseconds timeout{1000};
+};
+
+bool parse_option(Options& o, const std::string& arg) {
+    auto eq = arg.find('=');
+    if (arg.rfind("--", 0) != 0 || eq == std::string::npos) return false;
+    const std::string key = arg.substr(2, eq - 2), val = arg.substr(eq + 1);
+    if (key == "host") o.host = val;
+    else if (key == "port") o.port = val;
+    else if (key == "type") o.type = static_cast<uint8_t>(std::stoul(val, nullptr, 0));
+    else if (key == "rate") o.rate = std::stod(val);
+    else if (key == "connections") o.connections = std::stoul(val);
+    else if (key == "threads") o.threads = std::stoul(val);
+    else if (key == "size") o.size = std::stoul(val);
+    else if (key == "server-threads") o.server_threads = std::stoul(val);
+    else if (key == "duration") o.duration = std::stod(val);
+    else if (key == "warmup") o.warmup = std::stod(val);
+    else if (key == "timeout-ms") o.timeout = std::chrono::milliseconds(std::stol(val));
+    else return false;
+    return true;
+}
+
+// One thread: a pacing timer and the connections it spreads requests over
+class Worker {
+public:
+    Worker(const Options& o, std::size_t connections) : o_(o), payload_(o.size, 'x'), timer_(io_) {
+        for (std::size_t i = 0; i < connections; ++i)
+            clients_.push_back(std::make_shared<swiftwire::AsyncClient>(io_));
+    }
+
+    void connect(const std::string& host, const std::string& port, std::atomic<std::size_t>& connected) {
+        for (auto& c : clients_) {
+            c->async_connect(host, port, std::chrono::seconds(5), [&connected](auto ec) {
+                if (ec) std::cerr << "connect: " << ec.message() << "\n";
+                else ++connected;
+            });
+        }
+    }
+
+    // Schedule: first - interval ... < end, measured from `measure`
+    void start(clock_type::time_point first, clock_type::time_point measure,
+               clock_type::time_point end, clock_type::duration interval) {
+        boost::asio::post(io_, [=, this] {
+            next_ = first;
+            measure_ = measure;
+            end_ = end;
+            interval_ = interval;
+            pace();
+        });
+    }
+
+    boost::asio::io_context& io() noexcept { return io_; }
+
+    swiftwire::Histogram corrected, uncorrected, send_lag;
+    uint64_t sent = 0, ok = 0, errors = 0, timeouts = 0;
+
+private:
+    void pace() {
+        const auto now = clock_type::now();
+        while (next_ <= now && next_ < end_) {
+            send(next_);
+            next_ += interval_;
+        }
+        if (next_ >= end_) {
+            sending_done_ = true;
+            return maybe_finish();
+        }
+        timer_.expires_at(next_);
+        timer_.async_wait([this](const boost::system::error_code& ec) {
+            if (!ec) pace();
+        });
+    }
+
+    void send(clock_type::time_point intended) {
+        auto& client = clients_[rr_++ % clients_.size()];
+        const auto actual = clock_type::now();
+        const bool measured = intended >= measure_;
+        if (measured) {
+            ++sent;
+            send_lag.record(ns(actual - intended));
+        }
+        ++inflight_;
+        client->async_request(o_.type, payload_, o_.timeout,
+            [this, intended, actual, measured](auto ec, uint8_t, std::string_view) {
+                const auto done = clock_type::now();
+                --inflight_;
+                if (measured) {
+                    if (ec == boost::asio::error::timed_out) ++timeouts;
+                    else if (ec) ++errors;
+                    else {
+                        ++ok;
+                        corrected.record(ns(done - intended));
+                        uncorrected.record(ns(done - actual));
+                    }
+                }
+                maybe_finish();
+            });
+    }
+
+    void maybe_finish() {
+        if (!sending_done_ || inflight_ != 0) return;
+        for (auto& c : clients_) c->close();
+        work_.reset();
+    }
+
+    static uint64_t ns(clock_type::duration d) {
+        return static_cast<uint64_t>(std::max<std::int64_t>(0,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()));
+    }
+
+    const Options& o_;
+    std::string payload_;
+    boost::asio::io_context io_{1};
+    // Keeps run() alive between connecting and the start of the schedule
+    std::optional<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> work_{io_.get_executor()};
+    boost::asio::steady_timer timer_;
+    std::vector<swiftwire::AsyncClientPtr> clients_;
+    std::size_t rr_ = 0;
+    std::size_t inflight_ = 0;
+    bool sending_done_ = false;
+    clock_type::time_point next_, measure_, end_;
+    clock_type::duration interval_{};
+};
+
+int run(const Options& o) {
+    std::optional<swiftwire::AsyncServer> server;
+    std::string host = o.host, port = o.port;
+    if (host.empty()) {
+        swiftwire::ServerConfig cfg;
+        cfg.threads = o.server_threads;
+        server.emplace(swiftwire::tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}, cfg);
+        swiftwire::bench::install_echo(*server);
+        server->run();
+        host = "127.0.0.1";
+        port = std::to_string(server->local_endpoint().port());
+    }
+
+    const std::size_t nthreads = std::max<std::size_t>(1, o.threads);
+    const std::size_t nconns = std::max(o.connections, nthreads);
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (std::size_t i = 0; i < nthreads; ++i)
+        workers.push_back(std::make_unique<Worker>(o, nconns / nthreads + (i < nconns % nthreads ? 1 : 0)));
+
+    std::atomic<std::size_t> connected{0};
+    for (auto& w : workers) w->connect(host, port, connected);
+    std::vector<std::thread> threads;
+    for (auto& w : workers) threads.emplace_back([&w] { w->io().run(); });
+
+    const auto connect_deadline = clock_type::now() + std::chrono::seconds(5);
+    while (connected < nconns && clock_type::now() < connect_deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if (connected < nconns) {
+        std::cerr << "only " << connected << "/" << nconns << " connections established\n";
+        for (auto& w : workers) w->io().stop();
+        for (auto& t : threads) t.join();
+        return 1;
+    }
+
+    // Each thread carries rate/threads, phase-shifted so the merged schedule is even
+    const auto interval = std::chrono::duration_cast<clock_type::duration>(
+        std::chrono::duration<double>(double(nthreads) / o.rate));
+    const auto t0 = clock_type::now() + std::chrono::milliseconds(50);
+    const auto measure = t0 + std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(o.warmup));
+    const auto end = measure + std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(o.duration));
+    for (std::size_t i = 0; i < nthreads; ++i)
+        workers[i]->start(t0 + interval * i / nthreads, measure, end, interval);
+
+    for (auto& t : threads) t.join();
+    if (server) {
+        server->stop();
+        server->join();
+    }
+
+    swiftwire::Histogram corrected, uncorrected, lag;
+    uint64_t sent = 0, ok = 0, errors = 0, timeouts = 0;
+    for (auto& w : workers) {
+        corrected.merge(w->corrected);
+        uncorrected.merge(w->uncorrected);
+        lag.merge(w->send_lag);
+        sent += w->sent; ok += w->ok; errors += w->errors; timeouts += w->timeouts;
+    }
+    std::printf("target=%.0f req/s conns=%zu threads=%zu size=%zuB duration=%.1fs backend=%s\n",
+                o.rate, nconns, nthreads, o.size, o.duration, swiftwire::io_backend);
+    std::printf("  sent: %.0f req/s  ok=%llu errors=%llu timeouts=%llu\n", double(sent) / o.duration,
+                (unsigned long long)ok, (unsigned long long)errors, (unsigned long long)timeouts);
+    swiftwire::bench::print_latency("corrected  ", corrected);
+    swiftwire::bench::print_latency("uncorrected", uncorrected);
+    swiftwire::bench::print_latency("send lag   ", lag);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options o;
+    for (int i = 1; i < argc; ++i) {
+        if (!parse_option(o, argv[i])) {
+            std::cerr << "usage: swiftwire_loadgen [--host=H --port=P] [--type=N] [--rate=REQ_PER_SEC]\n"
+                         "                         [--connections=N] [--threads=N] [--size=BYTES]\n"
+                         "                         [--duration=SEC] [--warmup=SEC] [--timeout-ms=MS]\n"
+                         "                         [--server-threads=N]\n";
+            return 1;
+        }
+    }
+    if (o.rate <= 0) {
+        std::cerr << "--rate must be positive\n";
+        return 1;
+    }
+    try {
+        return run(o);
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal: " << e.what() << "\n";
+        return 1;
+    }
+}
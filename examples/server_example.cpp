@@ -6,31 +6,31 @@
 int main(int argc, char* argv[]) {
     const std::string host = (argc > 1) ? argv[1] : "0.0.0.0";
     const std::string port = (argc > 2) ? argv[2] : "9000";
+    const bool reuse_port = (argc > 3) && std::string(argv[3]) == "reuseport";
 
-    boost::asio::io_context io;
     swiftwire::ServerConfig cfg;
     cfg.threads = std::max(1u, std::thread::hardware_concurrency());
+    cfg.pin_threads = true;
+    cfg.reuse_port = reuse_port; // each shard binds its own listener
+    if (argc > 4) // Prometheus scrape target: http://host:<argv[4]>/metrics
+        cfg.metrics_endpoint = swiftwire::tcp::endpoint{
+            boost::asio::ip::make_address(host), static_cast<unsigned short>(std::stoi(argv[4]))};
 
     try {
+        // Thread-per-core: one io_context per worker, owned by the server
         swiftwire::AsyncServer server(
-            io,
             { boost::asio::ip::make_address(host), static_cast<unsigned short>(std::stoi(port)) },
             cfg
         );
         server.run();
 
-        // Run io_context on N threads
-        std::vector<std::thread> workers;
-        for (std::size_t i = 1; i < cfg.threads; ++i) {
-            workers.emplace_back([&]{ io.run(); });
-        }
-
         // Graceful shutdown
-        boost::asio::signal_set signals(io, SIGINT, SIGTERM);
-        signals.async_wait([&](auto, auto){ io.stop(); });
+        boost::asio::io_context signals_io;
+        boost::asio::signal_set signals(signals_io, SIGINT, SIGTERM);
+        signals.async_wait([&](auto, auto){ server.stop(); });
+        signals_io.run();
 
-        io.run();
-        for (auto& t : workers) t.join();
+        server.join();
     } catch (const std::exception& e) {
         std::cerr << "Fatal: " << e.what() << "\n";
         return 1;
@@ -2,46 +2,188 @@
 #include <boost/asio.hpp>
 #include <array>
 #include <vector>
-#include <functional>
 #include <cstdint>
 #include <chrono>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "swiftwire/fragment.hpp"
+#include "swiftwire/frame_buffer.hpp"
+#include "swiftwire/recv_buffer.hpp"
+#include "swiftwire/unique_handler.hpp"
+#include "swiftwire/write_queue.hpp"
 
 namespace swiftwire {
 using boost::asio::ip::tcp;
 
+// Owned copy of a response payload (inline up to 48 bytes, pooled above), so
+// it stays valid after completion for futures and resumed coroutines
+class Payload {
+public:
+    Payload() noexcept = default;
+    Payload(const char* data, std::size_t size) : buf_(size) {
+        if (size) std::memcpy(buf_.data(), data, size);
+    }
+
+    const char* data() const noexcept { return buf_.data(); }
+    std::size_t size() const noexcept { return buf_.size(); }
+    bool empty() const noexcept { return buf_.empty(); }
+    std::string_view view() const noexcept { return {buf_.data(), buf_.size()}; }
+    operator std::string_view() const noexcept { return view(); }
+
+private:
+    FrameBuffer buf_;
+};
+
+// Every async_* member accepts an Asio completion token: a callback,
+// use_awaitable, use_future, deferred (Boost >= 1.80), ... Completions are
+// delivered through the handler's associated executor (inline when that is
+// the client's io_context and we are already running on it). The client is
+// not thread-safe; start operations from the thread running its io_context.
 class AsyncClient : public std::enable_shared_from_this<AsyncClient> {
 public:
-    using ConnectHandler  = std::function<void(const boost::system::error_code&)>;
-    using HelloHandler    = std::function<void(const boost::system::error_code&, uint64_t /*id*/, uint8_t /*status*/)>;
+    using ConnectSignature  = void(boost::system::error_code);
+    using HelloSignature    = void(boost::system::error_code, uint64_t /*id*/, uint8_t /*status*/);
+    using ResponseSignature = void(boost::system::error_code, uint8_t /*type*/, Payload);
+    // Frames nobody is waiting for: pub/sub MESSAGEs and other server pushes.
+    // The payload is only valid during the call.
+    using MessageHandler    = std::function<void(uint8_t /*type*/, std::string_view /*payload*/)>;
 
     explicit AsyncClient(boost::asio::io_context& io);
 
     // Resolve + connect with deadline (single-thread-friendly)
-    void async_connect(const std::string& host,
-                       const std::string& port,
-                       std::chrono::milliseconds timeout,
-                       ConnectHandler handler);
+    template <typename CompletionToken>
+    auto async_connect(std::string host, std::string port, std::chrono::milliseconds timeout,
+                       CompletionToken&& token) {
+        return boost::asio::async_initiate<CompletionToken, ConnectSignature>(
+            [this](auto handler, std::string host, std::string port, std::chrono::milliseconds timeout) {
+                start_connect(host, port, timeout, make_completion<ConnectSignature>(std::move(handler)));
+            }, token, std::move(host), std::move(port), timeout);
+    }
 
     // Send HELLO and await HELLO_ACK with deadline
-    void async_handshake(uint64_t client_id,
-                         std::chrono::milliseconds timeout,
-                         HelloHandler handler);
+    template <typename CompletionToken>
+    auto async_handshake(uint64_t client_id, std::chrono::milliseconds timeout, CompletionToken&& token) {
+        return boost::asio::async_initiate<CompletionToken, HelloSignature>(
+            [this](auto handler, uint64_t client_id, std::chrono::milliseconds timeout) {
+                start_handshake(client_id, timeout, make_completion<HelloSignature>(std::move(handler)));
+            }, token, client_id, timeout);
+    }
+
+    // Send a correlated REQUEST and await its RESPONSE with deadline. Any
+    // number of requests may be outstanding; one read loop matches replies
+    // by correlation id. `payload` is copied when the operation starts.
+    template <typename CompletionToken>
+    auto async_request(uint8_t type, std::string_view payload, std::chrono::milliseconds timeout,
+                       CompletionToken&& token) {
+        return boost::asio::async_initiate<CompletionToken, ResponseSignature>(
+            [this](auto handler, uint8_t type, std::string_view payload, std::chrono::milliseconds timeout) {
+                start_request(type, payload, timeout, make_completion<ResponseSignature>(std::move(handler)));
+            }, token, type, payload, timeout);
+    }
+
+    std::size_t outstanding() const noexcept { return pending_.size(); }
+
+    // While a handler is set the client keeps reading with nothing
+    // outstanding; pass an empty one to let it go idle again
+    void on_message(MessageHandler handler);
 
-    // Graceful close
+    // Fire-and-forget frames, no response expected
+    void send(uint8_t type, std::string_view payload);
+    void publish(std::string_view topic, std::string_view data); // PUBLISH; topic up to 64 KiB - 1
+
+    // Send frames whose body exceeds `bytes` as FRAGMENT chunks of that size,
+    // interleaved with smaller frames (0, the default, sends them whole). A
+    // fragmented message completes after unfragmented ones sent behind it;
+    // each kind keeps its own order. The server reassembles them up to its
+    // max_message; fragments it sends are reassembled here regardless, up to
+    // 64 MiB.
+    void set_fragment_size(std::size_t bytes);
+
+    // Largest frame accepted from the server, like ServerConfig::max_frame
+    // on the other side (default 1 MiB). A larger one fails every
+    // outstanding operation and closes the connection; raise it to match a
+    // server that sends bigger unfragmented replies.
+    void set_max_frame(std::size_t bytes);
+
+    // Graceful close; outstanding operations complete with operation_aborted
     void close();
 
 private:
+    using clock = std::chrono::steady_clock;
+    struct Pending {
+        UniqueHandler<ResponseSignature> handler;
+        clock::time_point deadline;
+    };
+    using Deadline = std::pair<clock::time_point, uint32_t>;
+
+    // Type-erase a token's handler, routing its invocation through the
+    // handler's associated executor
+    template <typename Signature, typename Handler>
+    UniqueHandler<Signature> make_completion(Handler handler) {
+        return [handler = std::move(handler), io = io_.get_executor()](auto... args) mutable {
+            auto ex = boost::asio::get_associated_executor(handler, io);
+            boost::asio::dispatch(ex, [handler = std::move(handler), ... args = std::move(args)]() mutable {
+                std::move(handler)(std::move(args)...);
+            });
+        };
+    }
+
+    void start_connect(const std::string& host, const std::string& port, std::chrono::milliseconds timeout,
+                       UniqueHandler<ConnectSignature> handler);
+    void start_handshake(uint64_t client_id, std::chrono::milliseconds timeout,
+                         UniqueHandler<HelloSignature> handler);
+    void start_request(uint8_t type, std::string_view payload, std::chrono::milliseconds timeout,
+                       UniqueHandler<ResponseSignature> handler);
+
     template <typename F>
     void arm_timer(std::chrono::milliseconds timeout, F on_timeout);
     void cancel_timer();
 
+    void enqueue_write(FrameBuffer buf, WriteQueue::Lane lane = WriteQueue::bulk);
+    void do_write();
+    void do_read();
+    bool wants_read() const noexcept;
+    void release_idle_read();
+    bool parse_frames();
+    void handle_frame(const char* body, std::size_t len);
+    void complete_connect(const boost::system::error_code& ec);
+    void complete_hello(const boost::system::error_code& ec, uint64_t id, uint8_t status);
+    void arm_request_timer();
+    void expire_requests();
+    void drop_deadlines();
+    void fail_all(const boost::system::error_code& ec);
+
 private:
     boost::asio::io_context& io_;
     tcp::resolver resolver_;
     tcp::socket   socket_;
-    boost::asio::steady_timer timer_;
-    std::array<char, 4> lenbuf_{};
-    std::vector<char>   body_;
+    boost::asio::steady_timer timer_;          // connect / handshake deadline
+    boost::asio::steady_timer request_timer_;  // earliest request deadline
+    bool request_timer_armed_{false};
+
+    RecvBuffer rbuf_;
+    std::size_t read_hint_{1};
+    bool reading_{false};
+    WriteQueue write_queue_;
+    std::vector<boost::asio::const_buffer> iov_;
+
+    UniqueHandler<ConnectSignature> connect_handler_;
+    UniqueHandler<HelloSignature> hello_handler_;
+    uint64_t hello_id_{0};
+    MessageHandler message_handler_;
+
+    std::size_t fragment_size_{0};
+    std::size_t max_frame_{1u << 20};
+    uint32_t next_stream_{1};
+    Reassembler reassembler_;
+
+    uint32_t next_corr_id_{1};
+    std::unordered_map<uint32_t, Pending> pending_;
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<>> deadlines_;
 };
 
 using AsyncClientPtr = std::shared_ptr<AsyncClient>;
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include "swiftwire/server.hpp"
+
+namespace swiftwire {
+
+// client_id -> session, filled from HELLO by the server's default handler.
+// Lookups are lock-free: each shard is an open-addressing table of immutable
+// entries, and readers protect the table and entry they touch with hazard
+// pointers. Writers (HELLO and disconnect) take the shard's mutex and free
+// replaced memory once no reader still has it published.
+class ClientRegistry {
+public:
+    explicit ClientRegistry(std::size_t shards = 64);
+    ~ClientRegistry();
+    ClientRegistry(const ClientRegistry&) = delete;
+    ClientRegistry& operator=(const ClientRegistry&) = delete;
+
+    // Any thread, lock-free; an empty handle when the id is not connected
+    SessionHandle find(uint64_t client_id) const;
+
+    // find() + SessionHandle::send(); false when not connected
+    bool send(uint64_t client_id, FrameBuffer frame) const;
+    bool send(uint64_t client_id, uint8_t type, const void* payload, std::size_t size) const;
+
+    std::size_t size() const noexcept;
+
+private:
+    friend class AsyncServer::Session;
+    struct Entry;
+    struct Table;
+    struct Shard;
+
+    // Map id to the session identified by `owner`; returns the handle it displaced
+    SessionHandle insert(uint64_t client_id, SessionHandle handle, const void* owner);
+    // Remove id only while it still maps to `owner`
+    void erase(uint64_t client_id, const void* owner);
+
+    Shard& shard_for(uint64_t hash) const noexcept;
+    void grow(Shard& shard);
+    void retire(Shard& shard, Entry* entry);
+    void retire(Shard& shard, Table* table);
+    static void reclaim(Shard& shard);
+
+    std::unique_ptr<Shard[]> shards_;
+    std::size_t shard_mask_;
+};
+
+} // namespace swiftwire
@@ -0,0 +1,77 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "swiftwire/frame_buffer.hpp"
+#include "swiftwire/protocol.hpp"
+
+namespace swiftwire {
+
+// Split a frame body ([type][payload], without the length prefix) into
+// FRAGMENT frames carrying at most `chunk` body bytes each; emit(FrameBuffer)
+// is called once per fragment, in order.
+template <typename F>
+void fragment_body(const char* body, std::size_t len, std::size_t chunk, uint32_t stream, F&& emit) {
+    for (std::size_t off = 0; off < len; off += chunk) {
+        const std::size_t n = std::min(chunk, len - off);
+        auto frag = FrameBuffer::frame(proto::MSG_FRAGMENT, proto::FRAGMENT_HEADER_LEN + n);
+        proto::write_u32be(frag.payload(), stream);
+        proto::write_u32be(frag.payload() + 4, static_cast<uint32_t>(len));
+        std::memcpy(frag.payload() + proto::FRAGMENT_HEADER_LEN, body + off, n);
+        emit(std::move(frag));
+    }
+}
+
+// Collects FRAGMENT payloads back into message bodies. A connection may have
+// at most max_streams messages in flight, each up to max_message bytes, and
+// holds at most max_message bytes across all of them. A stream's buffer grows
+// with the chunks received rather than with the total its header announces.
+class Reassembler {
+public:
+    static constexpr std::size_t max_streams = 16;
+
+    // Body bytes held for incomplete messages
+    std::size_t buffered() const noexcept { return held_; }
+
+    // False on a protocol violation (the connection should be closed). When
+    // the payload completes a message, on_complete(body, len) sees it.
+    template <typename F>
+    bool add(const char* payload, std::size_t size, std::size_t max_message, F&& on_complete) {
+        if (size < proto::FRAGMENT_HEADER_LEN) return false;
+        const uint32_t id = proto::read_u32be(payload);
+        const uint32_t total = proto::read_u32be(payload + 4);
+        payload += proto::FRAGMENT_HEADER_LEN;
+        size -= proto::FRAGMENT_HEADER_LEN;
+
+        auto it = std::find_if(streams_.begin(), streams_.end(), [&](const Stream& s) { return s.id == id; });
+        if (it == streams_.end()) {
+            if (total == 0 || total > max_message || streams_.size() >= max_streams) return false;
+            streams_.push_back(Stream{id, total, {}});
+            it = streams_.end() - 1;
+        }
+        if (it->total != total || it->body.size() + size > total || held_ + size > max_message) return false;
+        const std::size_t need = it->body.size() + size;
+        if (need > it->body.capacity()) it->body.reserve(std::min<std::size_t>(total, std::max(need, 2 * it->body.capacity())));
+        it->body.insert(it->body.end(), payload, payload + size);
+        held_ += size;
+        if (it->body.size() < total) return true;
+
+        Stream done = std::move(*it);
+        streams_.erase(it);
+        held_ -= done.body.size();
+        on_complete(static_cast<const char*>(done.body.data()), done.body.size());
+        return true;
+    }
+
+private:
+    struct Stream {
+        uint32_t id;
+        uint32_t total;
+        std::vector<char> body;
+    };
+    std::vector<Stream> streams_;
+    std::size_t held_ = 0;
+};
+
+} // namespace swiftwire
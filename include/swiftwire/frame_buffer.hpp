@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace swiftwire {
+
+// Immutable, refcounted frame for fan-out: encoded once, then referenced by
+// any number of FrameBuffers without copying. Fill it before the first copy
+// is made; the bytes are read-only from then on. Copies and the buffers
+// referencing it may be released on any thread.
+class SharedFrame {
+public:
+    SharedFrame() noexcept = default;
+    explicit SharedFrame(std::size_t size);
+    SharedFrame(const SharedFrame& other) noexcept : data_(other.data_), size_(other.size_) { ref(data_); }
+    SharedFrame(SharedFrame&& other) noexcept : data_(std::exchange(other.data_, nullptr)),
+                                                size_(std::exchange(other.size_, 0)) {}
+    SharedFrame& operator=(SharedFrame other) noexcept {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        return *this;
+    }
+    ~SharedFrame() { unref(data_); }
+
+    // [4B length][1B type][payload_len bytes]; length and type are filled in
+    static SharedFrame frame(uint8_t type, std::size_t payload_len);
+
+    char* data() noexcept { return data_; }
+    const char* data() const noexcept { return data_; }
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    char* payload() noexcept { return data_ + 5; }
+    const char* payload() const noexcept { return data_ + 5; }
+
+private:
+    friend class FrameBuffer;
+    static void ref(char* data) noexcept;
+    static void unref(char* data) noexcept;
+
+    char* data_ = nullptr;
+    uint32_t size_ = 0;
+};
+
+// Move-only outbound frame. Small frames live in the inline storage; larger
+// ones borrow a size-classed block from a per-thread pool and give it back on
+// destruction, so steady-state sending performs no heap allocation.
+class FrameBuffer {
+public:
+    static constexpr std::size_t inline_capacity = 48;
+
+    FrameBuffer() noexcept = default;
+    explicit FrameBuffer(std::size_t size);
+    // References `frame` instead of copying it (one refcount increment)
+    explicit FrameBuffer(const SharedFrame& frame) noexcept;
+    FrameBuffer(FrameBuffer&& other) noexcept { steal(other); }
+    FrameBuffer& operator=(FrameBuffer&& other) noexcept {
+        if (this != &other) { release(); steal(other); }
+        return *this;
+    }
+    FrameBuffer(const FrameBuffer&) = delete;
+    FrameBuffer& operator=(const FrameBuffer&) = delete;
+    ~FrameBuffer() { release(); }
+
+    // [4B length][1B type][payload_len bytes]; length and type are filled in
+    static FrameBuffer frame(uint8_t type, std::size_t payload_len);
+
+    char* data() noexcept { return data_; }
+    const char* data() const noexcept { return data_; }
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    // Payload of a buffer built with frame()
+    char* payload() noexcept { return data_ + 5; }
+
+private:
+    static constexpr uint8_t kInline = 0xFF;
+    static constexpr uint8_t kHeap   = 0xFE;
+    static constexpr uint8_t kShared = 0xFD;   // data_ points into a SharedFrame block
+
+    void steal(FrameBuffer& other) noexcept;
+    void release() noexcept;
+
+    char* data_ = inline_;
+    uint32_t size_ = 0;
+    uint8_t cls_ = kInline;   // pool size class, kInline, kHeap or kShared
+    alignas(8) char inline_[inline_capacity];
+};
+
+} // namespace swiftwire
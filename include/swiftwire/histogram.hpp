@@ -0,0 +1,103 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <limits>
+
+namespace swiftwire {
+
+// HDR-style log-linear histogram: exact below 64, then 64 sub-buckets per
+// power of two (~1.6% relative error) up to 2^44. record() is meant for a
+// single writer thread and uses relaxed load/store pairs, so it costs the
+// same as plain increments; any thread may read or merge() concurrently.
+class Histogram {
+public:
+    static constexpr unsigned sub_bits = 6;
+    static constexpr unsigned max_bits = 44;
+    static constexpr uint64_t sub_count = uint64_t(1) << sub_bits;
+    static constexpr std::size_t bucket_count = (max_bits - sub_bits + 1) * sub_count;
+
+    Histogram() = default;
+    Histogram(const Histogram&) = delete;
+    Histogram& operator=(const Histogram&) = delete;
+
+    void record(uint64_t v, uint64_t n = 1) noexcept {
+        bump(buckets_[index(v)], n);
+        bump(count_, n);
+        bump(sum_, v * n);
+        if (v < min_.load(std::memory_order_relaxed)) min_.store(v, std::memory_order_relaxed);
+        if (v > max_.load(std::memory_order_relaxed)) max_.store(v, std::memory_order_relaxed);
+    }
+
+    // Add another histogram's counts into this one (single writer on `this`)
+    void merge(const Histogram& other) noexcept {
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            if (uint64_t n = other.buckets_[i].load(std::memory_order_relaxed)) bump(buckets_[i], n);
+        }
+        bump(count_, other.count());
+        bump(sum_, other.sum_.load(std::memory_order_relaxed));
+        if (other.count()) {
+            min_.store(std::min(min(), other.min()), std::memory_order_relaxed);
+            max_.store(std::max(max(), other.max()), std::memory_order_relaxed);
+        }
+    }
+
+    void reset() noexcept {
+        for (auto& b : buckets_) b.store(0, std::memory_order_relaxed);
+        count_.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        min_.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t count() const noexcept { return count_.load(std::memory_order_relaxed); }
+    uint64_t min() const noexcept { return count() ? min_.load(std::memory_order_relaxed) : 0; }
+    uint64_t max() const noexcept { return max_.load(std::memory_order_relaxed); }
+    double mean() const noexcept {
+        const uint64_t n = count();
+        return n ? double(sum_.load(std::memory_order_relaxed)) / double(n) : 0.0;
+    }
+
+    // Highest value equivalent to the bucket holding the p-th percentile (0..100)
+    uint64_t percentile(double p) const noexcept {
+        const uint64_t n = count();
+        if (n == 0) return 0;
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(p / 100.0 * double(n) + 0.5));
+        uint64_t seen = 0;
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if (seen >= rank) return std::min(highest_equivalent(i), max());
+        }
+        return max();
+    }
+
+    static std::size_t index(uint64_t v) noexcept {
+        constexpr uint64_t top = (uint64_t(1) << max_bits) - 1;
+        if (v > top) v = top;
+        if (v < sub_count) return static_cast<std::size_t>(v);
+        const unsigned shift = static_cast<unsigned>(std::bit_width(v)) - 1 - sub_bits;
+        return static_cast<std::size_t>(shift * sub_count + (v >> shift));
+    }
+
+    static uint64_t highest_equivalent(std::size_t idx) noexcept {
+        if (idx < sub_count) return idx;
+        const uint64_t shift = idx / sub_count - 1;
+        const uint64_t sub = idx - shift * sub_count;
+        return ((sub + 1) << shift) - 1;
+    }
+
+private:
+    static void bump(std::atomic<uint64_t>& a, uint64_t n) noexcept {
+        a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, bucket_count> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> min_{std::numeric_limits<uint64_t>::max()};
+    std::atomic<uint64_t> max_{0};
+};
+
+} // namespace swiftwire
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
 
 namespace swiftwire::proto {
@@ -6,7 +7,42 @@ namespace swiftwire::proto {
     inline constexpr uint8_t MSG_HELLO     = 0x01;
     inline constexpr uint8_t MSG_HELLO_ACK = 0x81;
 
+    // Correlated request/response envelope
+    //   REQUEST:  [1B type=0x02][4B corr_id][1B inner type][payload]
+    //   RESPONSE: [1B type=0x82][4B corr_id][1B inner type][payload]
+    inline constexpr uint8_t MSG_REQUEST   = 0x02;
+    inline constexpr uint8_t MSG_RESPONSE  = 0x82;
+    inline constexpr std::size_t ENVELOPE_LEN = 1 + 4 + 1;
+    // Inner response type for requests nobody handled: [1B status]
+    inline constexpr uint8_t MSG_ERROR     = 0xFF;
+
+    // Pub/sub (ServerConfig::pubsub); a REQUEST-wrapped SUBSCRIBE, UNSUBSCRIBE
+    // or PUBLISH is acknowledged with an empty response of the same type
+    //   SUBSCRIBE:   [1B type=0x03][topic]
+    //   UNSUBSCRIBE: [1B type=0x04][topic]
+    //   PUBLISH:     [1B type=0x05][2B topic_len][topic][data]
+    //   MESSAGE:     [1B type=0x85][2B topic_len][topic][data]  (server -> subscribers)
+    inline constexpr uint8_t MSG_SUBSCRIBE   = 0x03;
+    inline constexpr uint8_t MSG_UNSUBSCRIBE = 0x04;
+    inline constexpr uint8_t MSG_PUBLISH     = 0x05;
+    inline constexpr uint8_t MSG_MESSAGE     = 0x85;
+    inline constexpr std::size_t MAX_TOPIC_LEN = 0xFFFF;
+
+    // Fragmentation (ServerConfig::fragment_size, AsyncClient::set_fragment_size):
+    // a frame body ([type][payload]) too large to send at once travels as
+    // chunks, interleaved with other frames, and is handled once complete
+    //   FRAGMENT: [1B type=0x06][4B stream id][4B total body length][chunk]
+    inline constexpr uint8_t MSG_FRAGMENT    = 0x06;
+    inline constexpr std::size_t FRAGMENT_HEADER_LEN = 4 + 4;
+
     // Big-endian helpers
+    inline void write_u16be(char* p, uint16_t v) {
+        p[0] = static_cast<char>((v >> 8) & 0xFF);
+        p[1] = static_cast<char>( v       & 0xFF);
+    }
+    inline uint16_t read_u16be(const char* p) {
+        return static_cast<uint16_t>((uint16_t(uint8_t(p[0])) << 8) | uint8_t(p[1]));
+    }
     inline void write_u32be(char* p, uint32_t v) {
         p[0] = static_cast<char>((v >> 24) & 0xFF);
         p[1] = static_cast<char>((v >> 16) & 0xFF);
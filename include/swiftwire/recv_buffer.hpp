@@ -0,0 +1,74 @@
+#pragma once
+#include <boost/asio/buffer.hpp>
+#include <algorithm>
+#include <cstring>
+#include "swiftwire/frame_buffer.hpp"
+
+namespace swiftwire {
+
+// Reusable receive buffer: reads land in the free tail, complete frames are
+// parsed in place from the head. Unread bytes are compacted to the front
+// instead of wrapping so every frame stays contiguous for its handler.
+//
+// The storage is a FrameBuffer block, so it comes from and goes back to the
+// per-thread pool. A lazy buffer takes it on the first prepare() and can
+// hand it back with release() whenever nothing is buffered.
+class RecvBuffer {
+public:
+    explicit RecvBuffer(std::size_t capacity = 16 * 1024, bool lazy = false) : base_(capacity) {
+        if (!lazy) buf_ = FrameBuffer(capacity);
+    }
+
+    // Writable space of at least `min` bytes (compacting/growing as needed)
+    boost::asio::mutable_buffer prepare(std::size_t min = 1) {
+        if (buf_.empty()) buf_ = FrameBuffer(std::max(base_, min));
+        if (buf_.size() - tail_ < min) {
+            compact();
+            if (buf_.size() - tail_ < min) reallocate(tail_ + min);
+        }
+        return boost::asio::buffer(buf_.data() + tail_, buf_.size() - tail_);
+    }
+    void commit(std::size_t n) noexcept { tail_ += n; }
+
+    const char* data() const noexcept { return buf_.data() + head_; }
+    std::size_t size() const noexcept { return tail_ - head_; }
+
+    void consume(std::size_t n) noexcept {
+        head_ += n;
+        if (head_ == tail_) head_ = tail_ = 0;
+    }
+
+    // Drop growth left behind by an oversized frame once it has been consumed
+    void shrink() {
+        if (buf_.size() <= base_ || size() > base_) return;
+        compact();
+        reallocate(base_);
+    }
+
+    // Return the storage to the pool while empty
+    void release() noexcept {
+        if (size() == 0) buf_ = FrameBuffer();
+    }
+
+private:
+    void compact() noexcept {
+        if (head_ == 0) return;
+        std::memmove(buf_.data(), buf_.data() + head_, tail_ - head_);
+        tail_ -= head_;
+        head_ = 0;
+    }
+
+    // Contents must start at the front (head_ == 0)
+    void reallocate(std::size_t capacity) {
+        FrameBuffer fresh(capacity);
+        if (tail_) std::memcpy(fresh.data(), buf_.data(), tail_);
+        buf_ = std::move(fresh);
+    }
+
+    FrameBuffer buf_;
+    std::size_t base_;
+    std::size_t head_{0};
+    std::size_t tail_{0};
+};
+
+} // namespace swiftwire
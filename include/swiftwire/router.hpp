@@ -0,0 +1,134 @@
+#pragma once
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace swiftwire {
+
+class MessageContext;
+
+// One decoded frame: the 1-byte type and the payload that follows it.
+// `data` points into the session's receive buffer and is only valid for
+// the duration of the handler call.
+struct Message {
+    uint8_t type;
+    const char* data;
+    std::size_t size;
+};
+
+// One piece of a streamed frame (MessageRouter::on_stream), handed over as
+// it arrives. `data` is only valid for the duration of the handler call;
+// `offset` counts the payload bytes delivered before it.
+struct StreamChunk {
+    uint8_t type;
+    const char* data;
+    std::size_t size;
+    std::size_t offset;
+    std::size_t total;   // payload size of the whole frame
+
+    bool last() const noexcept { return offset + size == total; }
+};
+
+// Flat 256-entry dispatch table keyed by the frame type byte. Each entry is a
+// plain function pointer plus target, instantiated per handler type, so a
+// dispatch is one indexed load and one indirect call. Configure before the
+// server starts; the table is read-only afterwards.
+class MessageRouter {
+public:
+    using Thunk = void (*)(void* target, MessageContext& ctx, const Message& msg);
+    using StreamThunk = void (*)(void* target, MessageContext& ctx, const StreamChunk& chunk);
+
+    // Free function bound at compile time: router.on<MSG_X, &handle_x>();
+    template <uint8_t Type, void (*Fn)(MessageContext&, const Message&)>
+    void on() {
+        set(Type, {&call_fn<Fn>, nullptr});
+    }
+
+    // Callable object (lambda, functor) copied into the router
+    template <typename H>
+    void on(uint8_t type, H handler) {
+        set(type, {&call_obj<H>, own(std::move(handler))});
+    }
+
+    // Handler for every type without an explicit registration
+    template <typename H>
+    void fallback(H handler) {
+        Entry e{&call_obj<H>, own(std::move(handler))};
+        for (std::size_t t = 0; t < table_.size(); ++t)
+            if (!explicit_[t]) table_[t] = e;
+    }
+
+    // Frames of `type` are not buffered whole: the handler sees their payload
+    // in chunks as it is read, each at most a receive buffer's worth, down to
+    // an empty last chunk for an empty payload. Such frames may be up to
+    // ServerConfig::max_stream_frame long instead of max_frame.
+    template <typename H>
+    void on_stream(uint8_t type, H handler) {
+        streams_[type] = StreamEntry{&call_stream<H>, own(std::move(handler))};
+        stream_types_.set(type);
+    }
+
+    bool has(uint8_t type) const noexcept { return explicit_[type]; }
+    bool streams(uint8_t type) const noexcept { return stream_types_[type]; }
+    bool has_streams() const noexcept { return stream_types_.any(); }
+
+    void dispatch(MessageContext& ctx, const Message& msg) const {
+        const Entry& e = table_[msg.type];
+        e.fn(e.target, ctx, msg);
+    }
+
+    void dispatch(MessageContext& ctx, const StreamChunk& chunk) const {
+        const StreamEntry& e = streams_[chunk.type];
+        e.fn(e.target, ctx, chunk);
+    }
+
+private:
+    struct Entry {
+        Thunk fn = &ignore;
+        void* target = nullptr;
+    };
+
+    struct StreamEntry {
+        StreamThunk fn = nullptr;
+        void* target = nullptr;
+    };
+
+    static void ignore(void*, MessageContext&, const Message&) {}
+
+    template <void (*Fn)(MessageContext&, const Message&)>
+    static void call_fn(void*, MessageContext& ctx, const Message& msg) { Fn(ctx, msg); }
+
+    template <typename H>
+    static void call_obj(void* target, MessageContext& ctx, const Message& msg) {
+        (*static_cast<H*>(target))(ctx, msg);
+    }
+
+    template <typename H>
+    static void call_stream(void* target, MessageContext& ctx, const StreamChunk& chunk) {
+        (*static_cast<H*>(target))(ctx, chunk);
+    }
+
+    template <typename H>
+    void* own(H handler) {
+        auto p = std::make_shared<H>(std::move(handler));
+        owned_.push_back(p);
+        return p.get();
+    }
+
+    void set(uint8_t type, Entry e) {
+        table_[type] = e;
+        explicit_.set(type);
+    }
+
+    std::array<Entry, 256> table_{};
+    std::bitset<256> explicit_;
+    std::array<StreamEntry, 256> streams_{};
+    std::bitset<256> stream_types_;
+    std::vector<std::shared_ptr<void>> owned_;
+};
+
+} // namespace swiftwire
@@ -2,36 +2,227 @@
 #include <boost/asio.hpp>
 #include <atomic>
 #include <array>
+#include <bitset>
 #include <deque>
 #include <memory>
+#include <optional>
+#include <string_view>
 #include <vector>
 #include <cstdint>
+#include <cstring>
 #include <chrono>
 #include <thread>
+#include "swiftwire/frame_buffer.hpp"
+#include "swiftwire/router.hpp"
 
 namespace swiftwire {
 using boost::asio::ip::tcp;
 
+// Which Asio backend this build runs on (SWIFTWIRE_IO_URING, experimental)
+#if defined(BOOST_ASIO_HAS_IO_URING) && defined(BOOST_ASIO_DISABLE_EPOLL)
+inline constexpr const char* io_backend = "io_uring";
+#else
+inline constexpr const char* io_backend = "epoll";
+#endif
+
 struct ServerConfig {
     std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    bool pin_threads = false;                      // pin shard i to CPU i (thread-per-core mode, Linux)
     std::chrono::seconds idle_timeout{60};
+    bool idle_timer_wheel = false;                 // per-shard timer wheel instead of a steady_timer per session
+    std::chrono::milliseconds idle_wheel_tick{1000}; // wheel resolution
     std::size_t max_frame = 1u << 20;              // 1 MiB
-    std::size_t max_write_queue_bytes = 8u << 20;  // 8 MiB per connection
+    std::size_t max_message = 0;                   // a message reassembled from FRAGMENTs (0 = max_frame)
+    std::size_t max_stream_frame = 1u << 30;       // a frame of a MessageRouter::on_stream type
+    std::size_t fragment_size = 0;                 // send bodies above this as FRAGMENT chunks (0 = off);
+                                                   // later unfragmented frames may overtake them
+    std::size_t recv_buffer_size = 16u << 10;      // 16 KiB per connection, grows for larger frames
+    std::size_t max_write_queue_bytes = 8u << 20;  // 8 MiB per connection, hard cap: disconnect above
+    std::size_t write_high_watermark = 4u << 20;   // stop reading from the peer above this
+    std::size_t write_low_watermark = 1u << 20;    // resume reading at or below this
+    std::size_t max_write_batch_bytes = 256u << 10; // bytes gathered into one writev
+    std::size_t max_write_batch_iov = 64;          // buffers per writev (capped at 64)
     bool tcp_nodelay = true;
+    bool reuse_port = false;                       // SO_REUSEPORT: one listener per shard (or per process)
+    std::size_t accepts_in_flight = 1;             // accepts kept posted per listener (raise on io_uring)
+    bool stage_metrics = false;                    // per-thread stage latency histograms (see stage_metrics.hpp)
+    bool metrics = false;                          // per-thread server counters (see server_metrics.hpp)
+    std::optional<tcp::endpoint> metrics_endpoint; // serve them over HTTP for Prometheus (implies metrics)
+    bool pubsub = false;                           // built-in SUBSCRIBE/UNSUBSCRIBE/PUBLISH broker (protocol.hpp)
+    bool conflate_writes = false;                  // keyed frames replace unsent ones with the same key
+    // Message types written ahead of queued bulk frames, at frame boundaries
+    // (heartbeats, acks); by inner type for RESPONSE envelopes. HELLO_ACK always is.
+    std::bitset<256> control_types;
+    // For many mostly idle connections: receive buffers are borrowed from the
+    // per-thread pool only while bytes are pending, write-queue storage is
+    // freed once drained, and idle timeouts use the timer wheel (implies
+    // idle_timer_wheel). Costs an extra readiness wait per read.
+    bool low_footprint = false;
+    // Admission control: connections over a limit are closed as soon as they
+    // are accepted (0 = no limit). When accept fails for lack of descriptors
+    // or memory, the listener waits accept_backoff before accepting again.
+    std::size_t max_connections = 0;
+    std::size_t max_connections_per_ip = 0;        // by source address
+    std::chrono::milliseconds accept_backoff{100};
 };
 
+class MetricsHttp;
+class ClientRegistry;
+class Admission;
+
 class AsyncServer {
 public:
+    class Session;
+
+    // Shared reactor: the caller owns and runs `io`; each session runs on its own strand.
+    // Destroying the server closes its sessions on their strands; do it while
+    // `io` is not running (e.g. after io.stop()) or from a handler on `io`.
     AsyncServer(boost::asio::io_context& io, const tcp::endpoint& ep, ServerConfig cfg = {});
-    void run();   // start accepting
+
+    // Thread-per-core: the server owns cfg.threads io_contexts, each run by one thread.
+    // Accepted sockets are handed round-robin to shards and never leave them.
+    explicit AsyncServer(const tcp::endpoint& ep, ServerConfig cfg = {});
+
+    ~AsyncServer();
+    AsyncServer(const AsyncServer&) = delete;
+    AsyncServer& operator=(const AsyncServer&) = delete;
+
+    void run();   // start accepting (and the shard threads, if owned)
+    void stop();  // stop accepting; owned shards are stopped as well
+    void join();  // wait for owned shard threads to exit; closes their listeners after stop()
+
+    // Message handlers keyed by frame type; register before run()
+    MessageRouter& router() noexcept { return router_; }
+
+    // Sessions by the client_id they sent in HELLO (see client_registry.hpp).
+    // A second HELLO with a connected id evicts the older connection.
+    ClientRegistry& clients() noexcept { return *clients_; }
+
+    // Queue `frame` on every connected session, from any thread. It is
+    // encoded once and each write queue holds a reference; cross-thread
+    // traffic is one handoff per shard. For a subset of sessions, send
+    // FrameBuffer(frame) through their SessionHandles. A non-zero
+    // conflation_key applies as in SessionHandle::send(). Throws
+    // invalid_argument for a frame shorter than its length prefix and type.
+    void broadcast(const SharedFrame& frame, uint64_t conflation_key = 0);
+
+    // Deliver a MESSAGE to every subscriber of `topic` (cfg.pubsub), from any
+    // thread, like a PUBLISH from a client. Subscribers whose write queue is
+    // above write_high_watermark miss it instead of slowing the others; with
+    // cfg.conflate_writes they get the newest unsent MESSAGE per topic instead.
+    void publish(std::string_view topic, const void* data, std::size_t size);
+
+    std::size_t shard_count() const noexcept { return shards_.size(); }
+    tcp::endpoint local_endpoint() const;
+    tcp::endpoint metrics_local_endpoint() const; // requires cfg.metrics_endpoint
+
 private:
-    class Session;
-    void do_accept();
+    struct Shard;
+    void install_default_handlers();
+    void handle_hello(MessageContext& ctx, const Message& msg);
+    void handle_subscribe(MessageContext& ctx, const Message& msg, bool subscribe);
+    void handle_publish(MessageContext& ctx, const Message& msg);
+    void fan_out(const SharedFrame& message);
+    void open_listeners(tcp::endpoint ep);
+    void open_metrics();
+    void do_accept(Shard& listener);
+    void back_off_accept(Shard& listener);
+    void admit(Shard& target, tcp::socket socket);
+    Shard& next_shard();
+
+private:
+    std::shared_ptr<ClientRegistry> clients_;    // co-owned by the sessions
+    std::shared_ptr<Admission> admission_;       // likewise
+    std::shared_ptr<ServerConfig> config_;       // co-owned by the sessions
+    ServerConfig& cfg_;                          // *config_
+    MessageRouter router_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::unique_ptr<MetricsHttp> metrics_http_; // on the first shard's io_context; destroyed before it
+    bool owns_shards_;
+    std::size_t next_shard_{0};
+    std::vector<std::thread> threads_;
+};
+
+// Refers to a session from any thread without keeping it alive
+class SessionHandle {
+public:
+    SessionHandle() noexcept = default;
+
+    // Queue a complete frame from any thread. Frames sent by one thread keep
+    // their order; the session's thread is woken once per batch, not per
+    // frame. False once the session is gone or closed, or for a frame
+    // shorter than its length prefix and type. With
+    // cfg.conflate_writes, a non-zero conflation_key replaces a still unsent
+    // frame with the same key, which keeps its place in the queue.
+    bool send(FrameBuffer frame, uint64_t conflation_key = 0) const;
+    bool send(uint8_t type, const void* payload, std::size_t size) const;
+    void close() const;
+
+    bool expired() const noexcept { return session_.expired(); }
 
 private:
-    boost::asio::io_context& io_;
-    tcp::acceptor acceptor_;
-    ServerConfig cfg_;
+    friend class MessageContext;
+    friend class AsyncServer::Session;
+    explicit SessionHandle(std::weak_ptr<AsyncServer::Session> session) noexcept : session_(std::move(session)) {}
+    std::weak_ptr<AsyncServer::Session> session_;
 };
 
+// Handed to message handlers; valid only for the duration of the call unless
+// retained. Use it only on the session's executor.
+class MessageContext {
+public:
+    // Queue a complete frame on this connection; conflation_key as in SessionHandle::send().
+    // Throws invalid_argument for a frame shorter than its length prefix and type.
+    void send(FrameBuffer frame, uint64_t conflation_key = 0);
+    // Answer the current message; wrapped in a RESPONSE envelope when it arrived as a REQUEST
+    void reply(uint8_t type, const void* payload, std::size_t size);
+    void close();
+
+    bool correlated() const noexcept { return correlated_; }
+    uint32_t correlation_id() const noexcept { return corr_id_; }
+
+    // Thread-safe handle for sending to this connection later, from anywhere
+    SessionHandle handle() const;
+    // A copy that keeps the session alive, for replying after the handler returns
+    MessageContext retain() const;
+    // The session's executor (its shard, or its strand in shared-reactor mode)
+    boost::asio::any_io_executor get_executor() const;
+
+    // Stop reading from the peer until resume_reading(), e.g. while a
+    // streamed chunk is written somewhere slower; TCP flow control then
+    // holds the sender back. On the session's executor only.
+    void pause_reading();
+    void resume_reading();
+
+private:
+    friend class AsyncServer;
+    friend class AsyncServer::Session;
+    explicit MessageContext(AsyncServer::Session& session) noexcept : session_(session) {}
+    AsyncServer::Session& session_;
+    std::shared_ptr<AsyncServer::Session> keepalive_;
+    uint32_t corr_id_{0};
+    bool correlated_{false};
+};
+
+// Adapts a coroutine `awaitable<void>(MessageContext, Message)` into a router
+// handler. Each message is copied and the coroutine is spawned on the
+// session's executor with a retained context, so it may co_await downstream
+// work and reply later; replies pair with requests by correlation id rather
+// than by order. An escaping exception closes the connection.
+template <typename F>
+auto co_handler(F f) {
+    return [f = std::move(f)](MessageContext& ctx, const Message& msg) {
+        FrameBuffer body(msg.size);
+        if (msg.size) std::memcpy(body.data(), msg.data, msg.size);
+        auto run = [](const F& f, MessageContext ctx, uint8_t type, FrameBuffer body) -> boost::asio::awaitable<void> {
+            co_await f(ctx, Message{type, body.data(), body.size()});
+        };
+        auto ex = ctx.get_executor();
+        boost::asio::co_spawn(ex, run(f, ctx.retain(), msg.type, std::move(body)),
+            [ctx = ctx.retain()](std::exception_ptr e) mutable {
+                if (e) ctx.close();
+            });
+    };
+}
+
 } // namespace swiftwire
@@ -0,0 +1,75 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <boost/system/error_code.hpp>
+
+namespace swiftwire {
+
+// Why fail_and_close() ended a session
+enum class CloseReason : uint8_t {
+    peer_closed,      // eof / connection reset by the peer
+    idle_timeout,
+    frame_too_large,  // max_frame exceeded
+    write_overflow,   // max_write_queue_bytes exceeded
+    local_close,      // MessageContext::close() or server shutdown
+    other,
+};
+inline constexpr std::size_t close_reason_count = 6;
+
+CloseReason classify_close(const boost::system::error_code& ec) noexcept;
+const char* close_reason_name(CloseReason r) noexcept;
+
+// Why a connection was closed right after accept
+enum class RejectReason : uint8_t {
+    max_connections,         // ServerConfig::max_connections reached
+    max_connections_per_ip,  // its source address is at ServerConfig::max_connections_per_ip
+};
+inline constexpr std::size_t reject_reason_count = 2;
+
+const char* reject_reason_name(RejectReason r) noexcept;
+
+// Server counters (ServerConfig::metrics). Each thread owns one set and is its
+// only writer, so the data path pays one relaxed load and store per update
+// and never shares a cache line; sets are summed only when collected.
+// Gauges are kept as up/down counters whose per-thread values may wrap; the
+// sum across threads is exact.
+struct alignas(64) ServerCounters {
+    using counter = std::atomic<uint64_t>;
+
+    counter sessions_accepted{0};
+    counter sessions_closed{0};        // sessions destroyed; active = accepted - closed
+    counter bytes_in{0};
+    counter bytes_out{0};
+    counter write_queue_bytes{0};      // gauge: queued, not yet written
+    counter backpressure_pauses{0};    // reads paused at write_high_watermark
+    counter pubsub_dropped{0};         // MESSAGEs skipped for subscribers above write_high_watermark
+    counter frames_conflated{0};       // queued frames replaced by a newer one with the same key
+    counter accept_backoffs{0};        // accepting paused for accept_backoff (out of fds or memory)
+    std::array<counter, 256> frames_in{};   // by message type (inner type of REQUEST envelopes)
+    std::array<counter, 256> frames_out{};  // by message type (inner type of RESPONSE envelopes)
+    std::array<counter, close_reason_count> closes{};
+    std::array<counter, reject_reason_count> rejects{};
+
+    static void add(counter& c, uint64_t n = 1) noexcept {
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+    static void sub(counter& c, uint64_t n) noexcept {
+        c.store(c.load(std::memory_order_relaxed) - n, std::memory_order_relaxed);
+    }
+
+    // Add another set into this one (single writer on `this`)
+    void merge(const ServerCounters& other) noexcept;
+};
+
+// The calling thread's counters; sets outlive their thread so nothing is lost
+ServerCounters& local_server_counters();
+
+// Sum every thread's counters into `out`
+void collect_server_counters(ServerCounters& out);
+
+// Prometheus text exposition format (version 0.0.4)
+std::string render_prometheus(const ServerCounters& c);
+
+} // namespace swiftwire
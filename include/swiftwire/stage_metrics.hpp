@@ -0,0 +1,39 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include "swiftwire/histogram.hpp"
+
+namespace swiftwire {
+
+// Where a frame's time goes inside a Session (ServerConfig::stage_metrics)
+enum class Stage : uint8_t {
+    read_to_dispatch,     // read completion -> handler invoked (ns)
+    dispatch_to_enqueue,  // handler invoked -> reply enqueued (ns)
+    enqueue_to_write,     // reply enqueued -> fully written to the socket (ns)
+    queue_depth,          // frames already queued when a reply is enqueued
+};
+inline constexpr std::size_t stage_count = 4;
+
+struct StageHistograms {
+    std::array<Histogram, stage_count> stages;
+    Histogram& operator[](Stage s) noexcept { return stages[static_cast<std::size_t>(s)]; }
+    const Histogram& operator[](Stage s) const noexcept { return stages[static_cast<std::size_t>(s)]; }
+};
+
+// The calling thread's histograms. Each thread writes only its own set, so
+// recording takes no lock; sets outlive their thread so no samples are lost.
+StageHistograms& local_stage_metrics();
+
+// Merge every thread's histograms into `out` (lock-free for the recorders)
+void collect_stage_metrics(StageHistograms& out);
+
+// Zero every thread's histograms; only safe while no session is recording
+void reset_stage_metrics();
+
+inline uint64_t stage_clock_ns() noexcept {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace swiftwire
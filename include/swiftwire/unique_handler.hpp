@@ -0,0 +1,101 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace swiftwire {
+
+template <typename Signature>
+class UniqueHandler;
+
+// Move-only, call-once std::function replacement for completion handlers.
+// Targets up to inline_capacity bytes (lambdas, awaitable/future handlers
+// plus an executor) are stored in place, so parking one per outstanding
+// operation does not allocate; larger ones fall back to the heap.
+template <typename... Args>
+class UniqueHandler<void(Args...)> {
+public:
+    static constexpr std::size_t inline_capacity = 96;
+
+    UniqueHandler() noexcept = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, UniqueHandler>>>
+    UniqueHandler(F&& f) {
+        using Fn = std::decay_t<F>;
+        if constexpr (sizeof(Fn) <= inline_capacity && alignof(Fn) <= alignof(std::max_align_t) &&
+                      std::is_nothrow_move_constructible_v<Fn>) {
+            ::new (static_cast<void*>(storage_)) Fn(std::forward<F>(f));
+            ops_ = &inline_ops<Fn>;
+        } else {
+            *reinterpret_cast<Fn**>(storage_) = new Fn(std::forward<F>(f));
+            ops_ = &heap_ops<Fn>;
+        }
+    }
+
+    UniqueHandler(UniqueHandler&& other) noexcept { steal(other); }
+    UniqueHandler& operator=(UniqueHandler&& other) noexcept {
+        if (this != &other) { reset(); steal(other); }
+        return *this;
+    }
+    UniqueHandler(const UniqueHandler&) = delete;
+    UniqueHandler& operator=(const UniqueHandler&) = delete;
+    ~UniqueHandler() { reset(); }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+    // Invoke and release the target; the handler is empty afterwards
+    void operator()(Args... args) {
+        auto* ops = ops_;
+        ops_ = nullptr;
+        ops->invoke(storage_, std::forward<Args>(args)...);
+    }
+
+    void reset() noexcept {
+        if (ops_) ops_->destroy(storage_);
+        ops_ = nullptr;
+    }
+
+private:
+    struct Ops {
+        void (*invoke)(void*, Args&&...);   // calls, then destroys
+        void (*move)(void* dst, void* src) noexcept;
+        void (*destroy)(void*) noexcept;
+    };
+
+    template <typename Fn>
+    static constexpr Ops inline_ops{
+        [](void* p, Args&&... args) {
+            Fn f(std::move(*static_cast<Fn*>(p)));
+            static_cast<Fn*>(p)->~Fn();
+            std::move(f)(std::forward<Args>(args)...);
+        },
+        [](void* dst, void* src) noexcept {
+            ::new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        },
+        [](void* p) noexcept { static_cast<Fn*>(p)->~Fn(); },
+    };
+
+    template <typename Fn>
+    static constexpr Ops heap_ops{
+        [](void* p, Args&&... args) {
+            Fn* f = *static_cast<Fn**>(p);
+            struct Free { Fn* f; ~Free() { delete f; } } guard{f};
+            std::move(*f)(std::forward<Args>(args)...);
+        },
+        [](void* dst, void* src) noexcept { *static_cast<Fn**>(dst) = *static_cast<Fn**>(src); },
+        [](void* p) noexcept { delete *static_cast<Fn**>(p); },
+    };
+
+    void steal(UniqueHandler& other) noexcept {
+        ops_ = other.ops_;
+        if (ops_) ops_->move(storage_, other.storage_);
+        other.ops_ = nullptr;
+    }
+
+    const Ops* ops_ = nullptr;
+    alignas(std::max_align_t) unsigned char storage_[inline_capacity];
+};
+
+} // namespace swiftwire
@@ -0,0 +1,231 @@
+#pragma once
+#include <boost/asio/buffer.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "swiftwire/frame_buffer.hpp"
+
+namespace swiftwire {
+
+// Outbound frame queue used by Session and AsyncClient. It hands out the head
+// of the queue as one gather batch and retires whatever a writev consumed; a
+// partially written head keeps an offset so the next batch resumes there.
+//
+// Frames go into one of three lanes. Each batch starts with the partially
+// written frame, if any, then takes control frames, then one fragment, then
+// bulk frames, then further fragments. A handshake or heartbeat waits for at
+// most one frame already on the wire, never for the whole backlog, and the
+// chunks of a fragmented message interleave with small frames instead of
+// holding them back. Within a lane frames keep their order.
+//
+// Frames pushed with a non-zero key conflate: one replaces the queued frame
+// with the same key and lane in place, as long as no gather has handed that
+// frame out yet, so a slow reader gets the latest value per key. Untagged
+// frames never touch the key index.
+class WriteQueue {
+public:
+    // Asio passes at most this many buffers to a single writev
+    static constexpr std::size_t max_iov = 64;
+
+    enum Lane : uint8_t { control = 0, bulk = 1, fragment = 2 };
+
+    // Non-owning buffer sequence over an iovec scratch array
+    struct Batch {
+        const boost::asio::const_buffer* first;
+        const boost::asio::const_buffer* last;
+        const boost::asio::const_buffer* begin() const noexcept { return first; }
+        const boost::asio::const_buffer* end() const noexcept { return last; }
+    };
+
+    bool empty() const noexcept { return size() == 0; }
+    std::size_t size() const noexcept { // frames
+        return lanes_[control].q.size() + lanes_[bulk].q.size() + lanes_[fragment].q.size();
+    }
+    std::size_t bytes() const noexcept { return bytes_; }    // queued, not yet written
+
+    // `stamp` is opaque to the queue and handed back when the frame retires.
+    // Returns the size of the frame a keyed push replaced, 0 when appended.
+    std::size_t push(FrameBuffer buf, uint64_t stamp = 0, uint64_t key = 0, Lane lane = bulk) {
+        auto& l = lanes_[lane];
+        bytes_ += buf.size();
+        if (key == 0) {
+            l.q.push_back(Entry{std::move(buf), stamp, 0});
+            return 0;
+        }
+        const uint64_t seq = l.head_seq + l.q.size();
+        auto [it, fresh] = l.keyed.try_emplace(key, seq);
+        if (!fresh) {
+            const std::size_t pos = it->second - l.head_seq;
+            if (pos >= l.submitted && !(pos == 0 && partial_ == lane)) {
+                auto& e = l.q[pos];
+                const std::size_t displaced = e.buf.size();
+                bytes_ -= displaced;
+                e.buf = std::move(buf);
+                e.stamp = stamp;
+                return displaced;
+            }
+            it->second = seq; // the older one is already on its way out
+        }
+        l.q.push_back(Entry{std::move(buf), stamp, key});
+        return 0;
+    }
+
+    // At least one frame, then further ones while within both caps. The
+    // frames handed out stay fixed until the next consume().
+    Batch gather(std::vector<boost::asio::const_buffer>& iov, std::size_t iov_cap, std::size_t byte_cap) {
+        iov.clear();
+        run_count_ = 0;
+        std::size_t total = 0;
+        // Each lane's `submitted` doubles as the index of its next frame to hand out
+        auto take = [&](uint8_t lane, std::size_t max_frames) {
+            auto& l = lanes_[lane];
+            const std::size_t from = l.submitted;
+            const std::size_t until = std::min(l.q.size(), from + std::min(max_frames, l.q.size()));
+            std::size_t i = from;
+            for (; i < until && iov.size() < iov_cap; ++i) {
+                const std::size_t skip = (i == 0 && partial_ == lane) ? offset_ : 0;
+                const std::size_t len = l.q[i].buf.size() - skip;
+                if (!iov.empty() && total + len > byte_cap) break;
+                iov.emplace_back(l.q[i].buf.data() + skip, len);
+                total += len;
+            }
+            if (i > from) runs_[run_count_++] = Run{static_cast<Lane>(lane), i - from};
+            l.submitted = i;
+            return i == l.q.size();
+        };
+        for (auto& l : lanes_) l.submitted = 0;
+        if (partial_ != none) take(partial_, 1); // finish the frame on the wire before anything else
+        if (take(control, SIZE_MAX)) {
+            take(fragment, 1);
+            if (take(bulk, SIZE_MAX)) take(fragment, SIZE_MAX);
+        }
+        return Batch{iov.data(), iov.data() + iov.size()};
+    }
+
+    void consume(std::size_t n) {
+        consume(n, [](uint64_t) {});
+    }
+
+    // Retire n written bytes, calling on_retired(stamp) for each finished
+    // frame; frames retire in the order the last gather() handed them out
+    template <typename F>
+    void consume(std::size_t n, F&& on_retired) {
+        bytes_ -= n;
+        for (auto& l : lanes_) l.submitted = 0;
+        for (std::size_t r = 0; r < run_count_; ++r) {
+            auto& run = runs_[r];
+            auto& l = lanes_[run.lane];
+            for (; run.frames > 0 && n > 0; --run.frames) {
+                const std::size_t skip = (partial_ == run.lane) ? offset_ : 0;
+                const std::size_t left = l.q.front().buf.size() - skip;
+                if (n < left) {
+                    partial_ = run.lane;
+                    offset_ = skip + n;
+                    return;
+                }
+                n -= left;
+                partial_ = none;
+                offset_ = 0;
+                on_retired(l.q.front().stamp);
+                pop_front(l);
+            }
+        }
+    }
+
+    void clear() {
+        for (auto& l : lanes_) {
+            l.q.clear();
+            l.keyed.clear();
+            l.submitted = 0;
+        }
+        run_count_ = 0;
+        partial_ = none;
+        offset_ = 0;
+        bytes_ = 0;
+    }
+
+    // Give the lanes' storage back while nothing is queued, so an idle
+    // connection holds no queue memory; the next push allocates it again
+    void release() noexcept {
+        if (!empty()) return;
+        for (auto& l : lanes_) {
+            l.q.release();
+            l.keyed = {};
+        }
+    }
+
+private:
+    static constexpr uint8_t none = 0xFF;
+
+    // FIFO of queued frames. std::deque never moves an element on push_back
+    // or pop_front, so the buffers a gather() handed to the writev in flight
+    // stay where they are while more frames are queued (an inline
+    // FrameBuffer's bytes live inside its entry). The deque is created on
+    // the first push because an empty one already allocates its map and a
+    // first block.
+    template <typename T>
+    class Fifo {
+    public:
+        std::size_t size() const noexcept { return q_ ? q_->size() : 0; }
+        T& operator[](std::size_t i) noexcept { return (*q_)[i]; }
+        T& front() noexcept { return q_->front(); }
+
+        void push_back(T&& value) {
+            if (!q_) q_ = std::make_unique<std::deque<T>>();
+            q_->push_back(std::move(value));
+        }
+
+        void pop_front() noexcept { q_->pop_front(); }
+
+        void clear() noexcept {
+            if (q_) q_->clear();
+        }
+
+        void release() noexcept {
+            if (size() == 0) q_.reset();
+        }
+
+    private:
+        std::unique_ptr<std::deque<T>> q_;
+    };
+
+    struct Entry {
+        FrameBuffer buf;
+        uint64_t stamp;
+        uint64_t key;
+    };
+
+    struct LaneQueue {
+        Fifo<Entry> q;
+        std::unordered_map<uint64_t, uint64_t> keyed;  // key -> sequence number of its newest frame
+        uint64_t head_seq = 0;                         // sequence number of q.front()
+        std::size_t submitted = 0;                     // frames handed to the writev in flight
+    };
+
+    struct Run {
+        Lane lane;
+        std::size_t frames;
+    };
+
+    static void pop_front(LaneQueue& l) {
+        if (const uint64_t key = l.q.front().key) {
+            auto it = l.keyed.find(key);
+            if (it != l.keyed.end() && it->second == l.head_seq) l.keyed.erase(it);
+        }
+        l.q.pop_front();
+        ++l.head_seq;
+    }
+
+    std::array<LaneQueue, 3> lanes_;
+    std::array<Run, 5> runs_{};  // lanes of the last batch, in gather order
+    std::size_t run_count_{0};
+    uint8_t partial_{none};      // lane whose front frame is partially written
+    std::size_t offset_{0};
+    std::size_t bytes_{0};
+};
+
+} // namespace swiftwire
@@ -0,0 +1,112 @@
+#pragma once
+#include <boost/asio/ip/address.hpp>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace swiftwire {
+
+// Connection limits checked at accept (ServerConfig::max_connections and
+// max_connections_per_ip). An admitted connection holds a Slot for as long
+// as its session lives; destroying the slot, on whichever thread, gives the
+// connection back. Slots co-own the Admission, so a session may outlive the
+// server. With both limits at 0 nothing is counted.
+class Admission : public std::enable_shared_from_this<Admission> {
+public:
+    using Key = std::array<unsigned char, 16>;  // IPv4 as v4-mapped IPv6
+
+    enum class Verdict : uint8_t { admitted, over_limit, over_ip_limit };
+
+    class Slot {
+    public:
+        Slot() noexcept = default;
+        Slot(Slot&& other) noexcept : owner_(std::move(other.owner_)), ip_(other.ip_) {}
+        Slot& operator=(Slot&& other) noexcept {
+            if (this != &other) {
+                reset();
+                owner_ = std::move(other.owner_);
+                ip_ = other.ip_;
+            }
+            return *this;
+        }
+        Slot(const Slot&) = delete;
+        Slot& operator=(const Slot&) = delete;
+        ~Slot() { reset(); }
+
+        void reset() noexcept {
+            if (owner_) owner_->release(ip_);
+            owner_.reset();
+        }
+
+    private:
+        friend class Admission;
+        std::shared_ptr<Admission> owner_;
+        Key ip_{};
+    };
+
+    Admission(std::size_t max_connections, std::size_t max_per_ip) noexcept
+        : max_total_(max_connections), max_per_ip_(max_per_ip) {}
+    Admission(const Admission&) = delete;
+    Admission& operator=(const Admission&) = delete;
+
+    // On admission `slot` takes the connection's place in the counts.
+    // The Admission must be owned by a shared_ptr.
+    Verdict admit(const boost::asio::ip::address& ip, Slot& slot) {
+        if (max_total_ == 0 && max_per_ip_ == 0) return Verdict::admitted;
+        if (total_.fetch_add(1, std::memory_order_relaxed) >= max_total_ && max_total_) {
+            total_.fetch_sub(1, std::memory_order_relaxed);
+            return Verdict::over_limit;
+        }
+        const Key key = key_of(ip);
+        if (max_per_ip_) {
+            std::lock_guard<std::mutex> lk(mu_);
+            auto& n = per_ip_[key];
+            if (n >= max_per_ip_) {
+                total_.fetch_sub(1, std::memory_order_relaxed);
+                return Verdict::over_ip_limit;
+            }
+            ++n;
+        }
+        slot.reset();
+        slot.owner_ = shared_from_this();
+        slot.ip_ = key;
+        return Verdict::admitted;
+    }
+
+    std::size_t connections() const noexcept { return total_.load(std::memory_order_relaxed); }
+
+private:
+    struct KeyHash {
+        std::size_t operator()(const Key& k) const noexcept {
+            uint64_t hi, lo;
+            std::memcpy(&hi, k.data(), 8);
+            std::memcpy(&lo, k.data() + 8, 8);
+            return std::hash<uint64_t>{}(hi * 0x9e3779b97f4a7c15ull ^ lo);
+        }
+    };
+
+    static Key key_of(const boost::asio::ip::address& ip) {
+        if (ip.is_v4()) return boost::asio::ip::make_address_v6(boost::asio::ip::v4_mapped, ip.to_v4()).to_bytes();
+        return ip.to_v6().to_bytes();
+    }
+
+    void release(const Key& key) noexcept {
+        total_.fetch_sub(1, std::memory_order_relaxed);
+        if (!max_per_ip_) return;
+        std::lock_guard<std::mutex> lk(mu_);
+        auto it = per_ip_.find(key);
+        if (it != per_ip_.end() && --it->second == 0) per_ip_.erase(it);
+    }
+
+    const std::size_t max_total_;
+    const std::size_t max_per_ip_;
+    std::atomic<std::size_t> total_{0};
+    std::mutex mu_;
+    std::unordered_map<Key, std::size_t, KeyHash> per_ip_;  // admitted connections per source address
+};
+
+} // namespace swiftwire
@@ -1,107 +1,326 @@
 #include "swiftwire/client.hpp"
 #include "swiftwire/protocol.hpp"
+#include <cstring>
 
 namespace swiftwire {
 using namespace std::chrono_literals;
 namespace proto = swiftwire::proto;
 
+namespace {
+constexpr std::size_t kMaxMessage = 64u << 20; // reassembled from fragments
+constexpr std::size_t kMaxWriteBatch = 256u << 10;
+} // namespace
+
 AsyncClient::AsyncClient(boost::asio::io_context& io)
-    : io_(io), resolver_(io), socket_(io), timer_(io) {}
+    : io_(io), resolver_(io), socket_(io), timer_(io), request_timer_(io) {}
 
-void AsyncClient::async_connect(const std::string& host,
+// Whichever of resolve/connect/timeout finishes first completes the
+// operation; the others find connect_handler_ empty and return
+void AsyncClient::start_connect(const std::string& host,
                                 const std::string& port,
                                 std::chrono::milliseconds timeout,
-                                ConnectHandler handler) {
+                                UniqueHandler<ConnectSignature> handler) {
+    if (connect_handler_) {
+        return boost::asio::post(io_, [handler = std::move(handler)]() mutable {
+            handler(make_error_code(boost::asio::error::in_progress));
+        });
+    }
     auto self = shared_from_this();
-    auto done = std::make_shared<bool>(false);
+    connect_handler_ = std::move(handler);
 
-    arm_timer(timeout, [this, self, done, handler] {
-        if (*done) return;
-        *done = true;
+    arm_timer(timeout, [this, self] {
+        if (!connect_handler_) return;
         boost::system::error_code ig;
+        resolver_.cancel();
         socket_.cancel(ig);
         socket_.close(ig);
-        handler(make_error_code(boost::asio::error::timed_out));
+        complete_connect(make_error_code(boost::asio::error::timed_out));
     });
 
     resolver_.async_resolve(host, port,
-        [this, self, done, handler](auto ec, auto results) {
-            if (*done) return;
-            if (ec) { *done = true; cancel_timer(); return handler(ec); }
+        [this, self](auto ec, auto results) {
+            if (!connect_handler_) return;
+            if (ec) return complete_connect(ec);
             boost::asio::async_connect(socket_, results,
-                [this, self, done, handler](auto ec2, auto) {
-                    if (*done) return;
-                    *done = true;
-                    cancel_timer();
+                [this, self](auto ec2, auto) {
+                    if (!connect_handler_) return;
                     if (!ec2) {
                         boost::system::error_code ign;
                         socket_.set_option(tcp::no_delay(true), ign);
                     }
-                    handler(ec2);
+                    complete_connect(ec2);
                 });
         });
 }
 
-void AsyncClient::async_handshake(uint64_t client_id,
+void AsyncClient::start_handshake(uint64_t client_id,
                                   std::chrono::milliseconds timeout,
-                                  HelloHandler handler) {
+                                  UniqueHandler<HelloSignature> handler) {
+    if (hello_handler_) {
+        return boost::asio::post(io_, [handler = std::move(handler)]() mutable {
+            handler(make_error_code(boost::asio::error::in_progress), 0, 0);
+        });
+    }
     auto self = shared_from_this();
-    auto done = std::make_shared<bool>(false);
+    hello_handler_ = std::move(handler);
+    hello_id_ = client_id;
 
     // Build request: [4B len=9][1B type][8B id]
-    auto req = std::make_shared<std::array<char, 4 + 1 + 8>>();
-    proto::write_u32be(req->data(), 1 + 8);
-    (*req)[4] = static_cast<char>(proto::MSG_HELLO);
-    proto::write_u64be(req->data() + 5, client_id);
-
-    arm_timer(timeout, [this, self, done, handler] {
-        if (*done) return;
-        *done = true;
+    auto req = FrameBuffer::frame(proto::MSG_HELLO, 8);
+    proto::write_u64be(req.payload(), client_id);
+
+    arm_timer(timeout, [this, self] {
+        complete_hello(make_error_code(boost::asio::error::timed_out), 0, 0);
+        release_idle_read();
+    });
+    enqueue_write(std::move(req), WriteQueue::control); // not behind queued bulk requests
+    do_read();
+}
+
+void AsyncClient::start_request(uint8_t type,
+                                std::string_view payload,
+                                std::chrono::milliseconds timeout,
+                                UniqueHandler<ResponseSignature> handler) {
+    uint32_t id = next_corr_id_++;
+    while (id == 0 || pending_.count(id)) id = next_corr_id_++;
+
+    const auto deadline = clock::now() + timeout;
+    pending_.emplace(id, Pending{std::move(handler), deadline});
+    deadlines_.emplace(deadline, id);
+
+    // [4B len][1B REQUEST][4B corr_id][1B type][payload]
+    auto req = FrameBuffer::frame(proto::MSG_REQUEST, 4 + 1 + payload.size());
+    proto::write_u32be(req.payload(), id);
+    req.payload()[4] = static_cast<char>(type);
+    if (!payload.empty()) std::memcpy(req.payload() + 5, payload.data(), payload.size());
+
+    enqueue_write(std::move(req));
+    arm_request_timer();
+    do_read();
+}
+
+void AsyncClient::on_message(MessageHandler handler) {
+    message_handler_ = std::move(handler);
+    if (!socket_.is_open()) return;
+    if (message_handler_) do_read();
+    else release_idle_read();
+}
+
+void AsyncClient::send(uint8_t type, std::string_view payload) {
+    auto buf = FrameBuffer::frame(type, payload.size());
+    if (!payload.empty()) std::memcpy(buf.payload(), payload.data(), payload.size());
+    enqueue_write(std::move(buf));
+}
+
+void AsyncClient::publish(std::string_view topic, std::string_view data) {
+    if (topic.size() > proto::MAX_TOPIC_LEN)
+        throw boost::system::system_error(make_error_code(boost::asio::error::message_size));
+    // [4B len][1B PUBLISH][2B topic_len][topic][data]
+    auto buf = FrameBuffer::frame(proto::MSG_PUBLISH, 2 + topic.size() + data.size());
+    proto::write_u16be(buf.payload(), static_cast<uint16_t>(topic.size()));
+    std::memcpy(buf.payload() + 2, topic.data(), topic.size());
+    if (!data.empty()) std::memcpy(buf.payload() + 2 + topic.size(), data.data(), data.size());
+    enqueue_write(std::move(buf));
+}
+
+void AsyncClient::set_fragment_size(std::size_t bytes) {
+    fragment_size_ = bytes;
+}
+
+void AsyncClient::set_max_frame(std::size_t bytes) {
+    max_frame_ = bytes;
+}
+
+void AsyncClient::enqueue_write(FrameBuffer buf, WriteQueue::Lane lane) {
+    bool idle = write_queue_.empty();
+    if (fragment_size_ && buf.size() - 4 > fragment_size_) {
+        fragment_body(buf.data() + 4, buf.size() - 4, fragment_size_, next_stream_++,
+                      [&](FrameBuffer frag) { write_queue_.push(std::move(frag), 0, 0, WriteQueue::fragment); });
+    } else {
+        write_queue_.push(std::move(buf), 0, 0, lane);
+    }
+    if (idle) do_write();
+}
+
+void AsyncClient::do_write() {
+    if (write_queue_.empty()) return;
+    auto self = shared_from_this();
+    socket_.async_write_some(write_queue_.gather(iov_, WriteQueue::max_iov, kMaxWriteBatch),
+        [this, self](auto ec, std::size_t n) {
+            if (ec) {
+                // The stream is cut mid-frame: nothing more can be sent or
+                // answered on it, so close it and the read loop with it
+                write_queue_.clear();
+                cancel_timer();
+                boost::system::error_code ig;
+                socket_.shutdown(tcp::socket::shutdown_both, ig);
+                socket_.close(ig);
+                return fail_all(ec);
+            }
+            write_queue_.consume(n);
+            do_write();
+        });
+}
+
+// A single read loop serves every outstanding operation; it stops re-arming
+// once nothing is waiting so an idle client does not pin the io_context.
+void AsyncClient::do_read() {
+    if (reading_) return;
+    reading_ = true;
+    auto self = shared_from_this();
+    socket_.async_read_some(rbuf_.prepare(read_hint_),
+        [this, self](auto ec, std::size_t n) {
+            if (ec == boost::asio::error::operation_aborted && socket_.is_open()) {
+                reading_ = false;
+                if (wants_read()) do_read(); // cancelled by release_idle_read() while a new op started
+                return;
+            }
+            if (ec) {
+                reading_ = false;
+                return fail_all(ec);
+            }
+            rbuf_.commit(n);
+            // reading_ stays set while parsing: handlers that start new operations
+            // must not issue a read into the buffer being parsed
+            const bool ok = parse_frames();
+            reading_ = false;
+            if (ok && wants_read()) do_read();
+        });
+}
+
+bool AsyncClient::wants_read() const noexcept {
+    return static_cast<bool>(hello_handler_) || !pending_.empty() || static_cast<bool>(message_handler_);
+}
+
+void AsyncClient::release_idle_read() {
+    if (reading_ && !wants_read() && write_queue_.empty()) {
         boost::system::error_code ig;
         socket_.cancel(ig);
-        handler(make_error_code(boost::asio::error::timed_out), 0, 0);
+    }
+}
+
+bool AsyncClient::parse_frames() {
+    read_hint_ = 1;
+    while (rbuf_.size() >= 4) {
+        uint32_t blen = proto::read_u32be(rbuf_.data());
+        if (blen == 0 || blen > max_frame_) {
+            fail_all(make_error_code(boost::asio::error::message_size));
+            close();
+            return false;
+        }
+        if (rbuf_.size() - 4 < blen) {
+            read_hint_ = 4 + blen - rbuf_.size();
+            break;
+        }
+        handle_frame(rbuf_.data() + 4, blen);
+        rbuf_.consume(4 + blen);
+        if (!socket_.is_open()) return false;
+    }
+    if (rbuf_.size() == 0) rbuf_.shrink();
+    return true;
+}
+
+void AsyncClient::handle_frame(const char* body, std::size_t len) {
+    uint8_t type = static_cast<uint8_t>(body[0]);
+    switch (type) {
+        case proto::MSG_HELLO_ACK: {
+            if (!hello_handler_) return;
+            if (len < 1 + 8 + 1)
+                return complete_hello(make_error_code(boost::asio::error::invalid_argument), 0, 0);
+            uint64_t echoed = proto::read_u64be(body + 1);
+            if (echoed != hello_id_)
+                return complete_hello(make_error_code(boost::asio::error::fault), 0, 0);
+            return complete_hello({}, echoed, static_cast<uint8_t>(body[1 + 8]));
+        }
+        case proto::MSG_RESPONSE: {
+            if (len < proto::ENVELOPE_LEN) return;
+            auto it = pending_.find(proto::read_u32be(body + 1));
+            if (it == pending_.end()) return; // already timed out
+            auto handler = std::move(it->second.handler);
+            pending_.erase(it);
+            if (pending_.empty()) drop_deadlines();
+            uint8_t inner = static_cast<uint8_t>(body[5]);
+            boost::system::error_code ec;
+            if (inner == proto::MSG_ERROR) ec = make_error_code(boost::asio::error::operation_not_supported);
+            return handler(ec, inner, Payload(body + proto::ENVELOPE_LEN, len - proto::ENVELOPE_LEN));
+        }
+        case proto::MSG_FRAGMENT: {
+            const bool ok = reassembler_.add(body + 1, len - 1, kMaxMessage, [this](const char* msg, std::size_t n) {
+                if (static_cast<uint8_t>(msg[0]) != proto::MSG_FRAGMENT) handle_frame(msg, n);
+            });
+            if (!ok) {
+                fail_all(make_error_code(boost::asio::error::message_size));
+                close();
+            }
+            return;
+        }
+        default:
+            if (message_handler_) message_handler_(type, std::string_view(body + 1, len - 1));
+            return;
+    }
+}
+
+void AsyncClient::complete_connect(const boost::system::error_code& ec) {
+    if (!connect_handler_) return;
+    auto handler = std::move(connect_handler_);
+    cancel_timer();
+    handler(ec);
+}
+
+void AsyncClient::complete_hello(const boost::system::error_code& ec, uint64_t id, uint8_t status) {
+    if (!hello_handler_) return;
+    auto handler = std::move(hello_handler_);
+    cancel_timer();
+    handler(ec, id, status);
+}
+
+void AsyncClient::arm_request_timer() {
+    if (deadlines_.empty()) return;
+    const auto next = deadlines_.top().first;
+    if (request_timer_armed_ && next >= request_timer_.expiry()) return;
+    request_timer_armed_ = true;
+    request_timer_.expires_at(next);
+    auto self = shared_from_this();
+    request_timer_.async_wait([this, self](const boost::system::error_code& ec) {
+        if (ec == boost::asio::error::operation_aborted) return;
+        request_timer_armed_ = false;
+        expire_requests();
     });
+}
 
-    boost::asio::async_write(socket_, boost::asio::buffer(*req),
-        [this, self, done, handler, client_id](auto ec, auto) {
-            if (*done) return;
-            if (ec) { *done = true; cancel_timer(); return handler(ec, 0, 0); }
-
-            boost::asio::async_read(socket_, boost::asio::buffer(lenbuf_),
-                [this, self, done, handler, client_id](auto ec2, auto) {
-                    if (*done) return;
-                    if (ec2) { *done = true; cancel_timer(); return handler(ec2, 0, 0); }
-
-                    uint32_t blen = proto::read_u32be(lenbuf_.data());
-                    constexpr uint32_t kMax = 1u << 20;
-                    if (blen < (1 + 8 + 1) || blen > kMax) {
-                        *done = true; cancel_timer();
-                        return handler(make_error_code(boost::asio::error::invalid_argument), 0, 0);
-                    }
-                    body_.resize(blen);
-
-                    boost::asio::async_read(socket_, boost::asio::buffer(body_),
-                        [this, self, done, handler, client_id](auto ec3, auto) {
-                            if (*done) return;
-                            *done = true;
-                            cancel_timer();
-                            if (ec3) return handler(ec3, 0, 0);
-
-                            if (body_.size() < 1 + 8 + 1)
-                                return handler(make_error_code(boost::asio::error::invalid_argument), 0, 0);
-                            uint8_t type = static_cast<uint8_t>(body_[0]);
-                            if (type != proto::MSG_HELLO_ACK)
-                                return handler(make_error_code(boost::asio::error::fault), 0, 0);
-
-                            uint64_t echoed = proto::read_u64be(body_.data() + 1);
-                            if (echoed != client_id)
-                                return handler(make_error_code(boost::asio::error::fault), 0, 0);
-
-                            uint8_t status = static_cast<uint8_t>(body_[1 + 8]);
-                            return handler({}, echoed, status);
-                        });
-                });
-        });
+void AsyncClient::expire_requests() {
+    const auto now = clock::now();
+    while (!deadlines_.empty() && deadlines_.top().first <= now) {
+        auto [deadline, id] = deadlines_.top();
+        deadlines_.pop();
+        auto it = pending_.find(id);
+        if (it == pending_.end() || it->second.deadline != deadline) continue; // answered already
+        auto handler = std::move(it->second.handler);
+        pending_.erase(it);
+        handler(make_error_code(boost::asio::error::timed_out), 0, Payload{});
+    }
+    if (pending_.empty()) drop_deadlines();
+    else arm_request_timer();
+    release_idle_read();
+}
+
+// Deadlines of answered requests linger in the heap; once nothing is
+// outstanding drop them so a stale timer does not keep the io_context busy
+void AsyncClient::drop_deadlines() {
+    deadlines_ = {};
+    if (request_timer_armed_) {
+        request_timer_armed_ = false;
+        request_timer_.cancel();
+    }
+}
+
+void AsyncClient::fail_all(const boost::system::error_code& ec) {
+    complete_connect(ec);
+    complete_hello(ec, 0, 0);
+    auto pending = std::move(pending_);
+    pending_.clear();
+    drop_deadlines();
+    for (auto& [id, p] : pending) p.handler(ec, 0, Payload{});
 }
 
 template <typename F>
@@ -126,6 +345,7 @@ void AsyncClient::close() {
     boost::system::error_code ec;
     socket_.shutdown(tcp::socket::shutdown_both, ec);
     socket_.close(ec);
+    fail_all(make_error_code(boost::asio::error::operation_aborted));
 }
 
 // Explicit template instantiation for MSVC linkers (optional)
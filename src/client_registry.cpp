@@ -0,0 +1,265 @@
+#include "swiftwire/client_registry.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <mutex>
+#include <vector>
+
+namespace swiftwire {
+namespace {
+
+// Hazard pointers: every reader thread owns a record publishing the table
+// and the entry it is currently reading. Records are registered once per
+// thread and never freed, like the per-thread metrics sets.
+struct HazardRecord {
+    std::atomic<const void*> table{nullptr};
+    std::atomic<const void*> entry{nullptr};
+};
+
+struct HazardList {
+    std::mutex mu;
+    std::vector<std::unique_ptr<HazardRecord>> records;
+};
+
+HazardList& hazard_list() {
+    static HazardList* l = new HazardList; // intentionally leaked: readers may run during static destruction
+    return *l;
+}
+
+HazardRecord& local_hazards() {
+    thread_local HazardRecord* mine = [] {
+        auto& l = hazard_list();
+        std::lock_guard<std::mutex> lk(l.mu);
+        l.records.push_back(std::make_unique<HazardRecord>());
+        return l.records.back().get();
+    }();
+    return *mine;
+}
+
+// Publish the pointer held by `src`, then confirm it is still there: once
+// confirmed, a writer that unlinks it afterwards will see the hazard
+template <typename T>
+T* protect(const std::atomic<T*>& src, std::atomic<const void*>& hazard) noexcept {
+    T* p = src.load(std::memory_order_relaxed);
+    for (;;) {
+        hazard.store(p, std::memory_order_seq_cst);
+        T* again = src.load(std::memory_order_seq_cst);
+        if (again == p) return p;
+        p = again;
+    }
+}
+
+uint64_t mix(uint64_t x) noexcept { // splitmix64 finalizer
+    x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27; x *= 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+constexpr std::size_t kMinCapacity = 16;
+constexpr std::size_t kReclaimBatch = 64;
+
+} // namespace
+
+struct ClientRegistry::Entry {
+    uint64_t id;
+    SessionHandle handle;
+    const void* owner;
+};
+
+struct ClientRegistry::Table {
+    explicit Table(std::size_t capacity)
+        : mask(capacity - 1), slots(std::make_unique<std::atomic<Entry*>[]>(capacity)) {}
+
+    std::size_t capacity() const noexcept { return mask + 1; }
+
+    const std::size_t mask;
+    std::unique_ptr<std::atomic<Entry*>[]> slots;  // null = never used, tombstone = erased
+    std::size_t used = 0;                          // non-null slots (writer only)
+};
+
+struct alignas(64) ClientRegistry::Shard {
+    std::mutex mu;
+    std::atomic<Table*> table{new Table(kMinCapacity)};
+    std::atomic<std::size_t> live{0};
+    std::vector<Entry*> retired_entries;
+    std::vector<Table*> retired_tables;
+};
+
+namespace {
+// Marks an erased slot so probe chains stay intact; never dereferenced
+alignas(8) char tombstone_storage;
+template <typename E>
+E* tombstone() noexcept { return reinterpret_cast<E*>(&tombstone_storage); }
+} // namespace
+
+ClientRegistry::ClientRegistry(std::size_t shards)
+    : shards_(std::make_unique<Shard[]>(std::bit_ceil(std::max<std::size_t>(1, shards)))),
+      shard_mask_(std::bit_ceil(std::max<std::size_t>(1, shards)) - 1) {}
+
+ClientRegistry::~ClientRegistry() {
+    for (std::size_t s = 0; s <= shard_mask_; ++s) {
+        auto& shard = shards_[s];
+        Table* t = shard.table.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < t->capacity(); ++i) {
+            Entry* e = t->slots[i].load(std::memory_order_relaxed);
+            if (e && e != tombstone<Entry>()) delete e;
+        }
+        delete t;
+        for (auto* e : shard.retired_entries) delete e;
+        for (auto* old : shard.retired_tables) delete old;
+    }
+}
+
+ClientRegistry::Shard& ClientRegistry::shard_for(uint64_t hash) const noexcept {
+    return shards_[(hash >> 48) & shard_mask_];
+}
+
+SessionHandle ClientRegistry::find(uint64_t client_id) const {
+    const uint64_t h = mix(client_id);
+    auto& shard = shard_for(h);
+    auto& hz = local_hazards();
+    SessionHandle found;
+    for (;;) {
+        Table* t = protect(shard.table, hz.table);
+        bool hit = false;
+        for (std::size_t i = h & t->mask, n = 0; n < t->capacity(); i = (i + 1) & t->mask, ++n) {
+            Entry* e = protect(t->slots[i], hz.entry);
+            if (!e) break;
+            if (e != tombstone<Entry>() && e->id == client_id) {
+                found = e->handle;
+                hit = true;
+                break;
+            }
+        }
+        // A miss in a table that was replaced meanwhile may be a resize artefact
+        if (hit || shard.table.load(std::memory_order_seq_cst) == t) break;
+    }
+    hz.entry.store(nullptr, std::memory_order_release);
+    hz.table.store(nullptr, std::memory_order_release);
+    return found;
+}
+
+bool ClientRegistry::send(uint64_t client_id, FrameBuffer frame) const {
+    return find(client_id).send(std::move(frame));
+}
+
+bool ClientRegistry::send(uint64_t client_id, uint8_t type, const void* payload, std::size_t size) const {
+    return find(client_id).send(type, payload, size);
+}
+
+std::size_t ClientRegistry::size() const noexcept {
+    std::size_t n = 0;
+    for (std::size_t s = 0; s <= shard_mask_; ++s) n += shards_[s].live.load(std::memory_order_relaxed);
+    return n;
+}
+
+SessionHandle ClientRegistry::insert(uint64_t client_id, SessionHandle handle, const void* owner) {
+    const uint64_t h = mix(client_id);
+    auto& shard = shard_for(h);
+    std::lock_guard<std::mutex> lk(shard.mu);
+    Table* t = shard.table.load(std::memory_order_relaxed);
+    if ((t->used + 1) * 2 > t->capacity()) {
+        grow(shard);
+        t = shard.table.load(std::memory_order_relaxed);
+    }
+
+    std::atomic<Entry*>* free_slot = nullptr;
+    for (std::size_t i = h & t->mask;; i = (i + 1) & t->mask) {
+        auto& slot = t->slots[i];
+        Entry* e = slot.load(std::memory_order_relaxed);
+        if (e == tombstone<Entry>()) {
+            if (!free_slot) free_slot = &slot;
+            continue;
+        }
+        if (!e) {
+            if (!free_slot) {
+                free_slot = &slot;
+                ++t->used;
+            }
+            break;
+        }
+        if (e->id == client_id) {
+            SessionHandle displaced = e->handle;
+            slot.store(new Entry{client_id, std::move(handle), owner}, std::memory_order_seq_cst);
+            retire(shard, e);
+            return displaced;
+        }
+    }
+    free_slot->store(new Entry{client_id, std::move(handle), owner}, std::memory_order_seq_cst);
+    shard.live.fetch_add(1, std::memory_order_relaxed);
+    return {};
+}
+
+void ClientRegistry::erase(uint64_t client_id, const void* owner) {
+    const uint64_t h = mix(client_id);
+    auto& shard = shard_for(h);
+    std::lock_guard<std::mutex> lk(shard.mu);
+    Table* t = shard.table.load(std::memory_order_relaxed);
+    for (std::size_t i = h & t->mask, n = 0; n < t->capacity(); i = (i + 1) & t->mask, ++n) {
+        auto& slot = t->slots[i];
+        Entry* e = slot.load(std::memory_order_relaxed);
+        if (!e) return;
+        if (e == tombstone<Entry>() || e->id != client_id) continue;
+        if (e->owner != owner) return; // a newer connection took the id over
+        slot.store(tombstone<Entry>(), std::memory_order_seq_cst);
+        shard.live.fetch_sub(1, std::memory_order_relaxed);
+        retire(shard, e);
+        return;
+    }
+}
+
+// Rehash live entries into a table sized for them, dropping tombstones. The
+// old table's slots are cleared so a reader still probing it cannot confirm
+// an entry that is later erased from the new one; its miss is retried.
+void ClientRegistry::grow(Shard& shard) {
+    Table* old = shard.table.load(std::memory_order_relaxed);
+    const std::size_t live = shard.live.load(std::memory_order_relaxed);
+    auto* t = new Table(std::max(kMinCapacity, std::bit_ceil((live + 1) * 4)));
+    for (std::size_t i = 0; i < old->capacity(); ++i) {
+        Entry* e = old->slots[i].load(std::memory_order_relaxed);
+        if (!e || e == tombstone<Entry>()) continue;
+        std::size_t j = mix(e->id) & t->mask;
+        while (t->slots[j].load(std::memory_order_relaxed)) j = (j + 1) & t->mask;
+        t->slots[j].store(e, std::memory_order_relaxed);
+        ++t->used;
+    }
+    shard.table.store(t, std::memory_order_seq_cst);
+    for (std::size_t i = 0; i < old->capacity(); ++i) old->slots[i].store(nullptr, std::memory_order_seq_cst);
+    retire(shard, old);
+}
+
+void ClientRegistry::retire(Shard& shard, Entry* entry) {
+    shard.retired_entries.push_back(entry);
+    if (shard.retired_entries.size() + shard.retired_tables.size() >= kReclaimBatch) reclaim(shard);
+}
+
+void ClientRegistry::retire(Shard& shard, Table* table) {
+    shard.retired_tables.push_back(table);
+    if (shard.retired_entries.size() + shard.retired_tables.size() >= kReclaimBatch) reclaim(shard);
+}
+
+// Free every retired pointer that no reader has published
+void ClientRegistry::reclaim(Shard& shard) {
+    std::vector<const void*> hazards;
+    {
+        auto& l = hazard_list();
+        std::lock_guard<std::mutex> lk(l.mu);
+        hazards.reserve(l.records.size() * 2);
+        for (auto& r : l.records) {
+            if (auto* p = r->table.load(std::memory_order_seq_cst)) hazards.push_back(p);
+            if (auto* p = r->entry.load(std::memory_order_seq_cst)) hazards.push_back(p);
+        }
+    }
+    std::sort(hazards.begin(), hazards.end());
+    auto in_use = [&](const void* p) { return std::binary_search(hazards.begin(), hazards.end(), p); };
+
+    auto sweep = [&](auto& retired) {
+        auto keep = std::partition(retired.begin(), retired.end(), [&](auto* p) { return in_use(p); });
+        for (auto it = keep; it != retired.end(); ++it) delete *it;
+        retired.erase(keep, retired.end());
+    };
+    sweep(shard.retired_entries);
+    sweep(shard.retired_tables);
+}
+
+} // namespace swiftwire
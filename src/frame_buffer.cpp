@@ -0,0 +1,154 @@
+#include "swiftwire/frame_buffer.hpp"
+#include "swiftwire/protocol.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <new>
+
+namespace swiftwire {
+namespace {
+
+// Size classes 256 B .. 4 MiB in powers of four; anything bigger goes straight to the heap
+constexpr std::size_t kClasses = 8;
+constexpr std::size_t class_size(std::size_t cls) { return std::size_t(256) << (2 * cls); }
+constexpr std::size_t kMaxCachedBytes = 1u << 20; // per class, per thread
+
+std::size_t class_for(std::size_t size) {
+    for (std::size_t cls = 0; cls < kClasses; ++cls)
+        if (size <= class_size(cls)) return cls;
+    return kClasses;
+}
+
+// Per-thread free lists threaded through the cached blocks themselves
+class FramePool {
+public:
+    ~FramePool() {
+        for (auto* head : free_) {
+            while (head) {
+                auto* next = head->next;
+                ::operator delete(head);
+                head = next;
+            }
+        }
+    }
+
+    void* acquire(std::size_t cls) {
+        if (auto* node = free_[cls]) {
+            free_[cls] = node->next;
+            --count_[cls];
+            return node;
+        }
+        return ::operator new(class_size(cls));
+    }
+
+    void release(void* block, std::size_t cls) noexcept {
+        const std::size_t limit = std::max<std::size_t>(2, kMaxCachedBytes / class_size(cls));
+        if (count_[cls] >= limit) return ::operator delete(block);
+        auto* node = static_cast<Node*>(block);
+        node->next = free_[cls];
+        free_[cls] = node;
+        ++count_[cls];
+    }
+
+private:
+    struct Node { Node* next; };
+    std::array<Node*, kClasses> free_{};
+    std::array<std::size_t, kClasses> count_{};
+};
+
+FramePool& local_pool() {
+    thread_local FramePool pool;
+    return pool;
+}
+
+// Precedes a SharedFrame's bytes in the same allocation
+struct SharedHeader {
+    std::atomic<uint32_t> refs;
+    uint32_t reserved;
+};
+static_assert(sizeof(SharedHeader) == 8);
+
+SharedHeader* header_of(char* data) noexcept {
+    return reinterpret_cast<SharedHeader*>(data - sizeof(SharedHeader));
+}
+
+} // namespace
+
+SharedFrame::SharedFrame(std::size_t size) : size_(static_cast<uint32_t>(size)) {
+    auto* block = static_cast<char*>(::operator new(sizeof(SharedHeader) + size));
+    ::new (block) SharedHeader{{1}, 0};
+    data_ = block + sizeof(SharedHeader);
+}
+
+SharedFrame SharedFrame::frame(uint8_t type, std::size_t payload_len) {
+    SharedFrame f(4 + 1 + payload_len);
+    proto::write_u32be(f.data_, static_cast<uint32_t>(1 + payload_len));
+    f.data_[4] = static_cast<char>(type);
+    return f;
+}
+
+void SharedFrame::ref(char* data) noexcept {
+    if (data) header_of(data)->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SharedFrame::unref(char* data) noexcept {
+    if (!data) return;
+    auto* h = header_of(data);
+    if (h->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+    h->~SharedHeader();
+    ::operator delete(h);
+}
+
+FrameBuffer::FrameBuffer(const SharedFrame& frame) noexcept
+    : data_(frame.data_), size_(frame.size_), cls_(kShared) {
+    SharedFrame::ref(data_);
+    if (!data_) {
+        data_ = inline_;
+        cls_ = kInline;
+    }
+}
+
+FrameBuffer::FrameBuffer(std::size_t size) : size_(static_cast<uint32_t>(size)) {
+    if (size <= inline_capacity) return;
+    const std::size_t cls = class_for(size);
+    if (cls == kClasses) {
+        data_ = static_cast<char*>(::operator new(size));
+        cls_ = kHeap;
+    } else {
+        data_ = static_cast<char*>(local_pool().acquire(cls));
+        cls_ = static_cast<uint8_t>(cls);
+    }
+}
+
+FrameBuffer FrameBuffer::frame(uint8_t type, std::size_t payload_len) {
+    FrameBuffer buf(4 + 1 + payload_len);
+    proto::write_u32be(buf.data_, static_cast<uint32_t>(1 + payload_len));
+    buf.data_[4] = static_cast<char>(type);
+    return buf;
+}
+
+void FrameBuffer::steal(FrameBuffer& other) noexcept {
+    size_ = other.size_;
+    cls_ = other.cls_;
+    if (cls_ == kInline) {
+        data_ = inline_;
+        std::memcpy(inline_, other.inline_, size_);
+    } else {
+        data_ = other.data_;
+    }
+    other.data_ = other.inline_;
+    other.size_ = 0;
+    other.cls_ = kInline;
+}
+
+void FrameBuffer::release() noexcept {
+    if (cls_ == kHeap) ::operator delete(data_);
+    else if (cls_ == kShared) SharedFrame::unref(data_);
+    else if (cls_ != kInline) local_pool().release(data_, cls_);
+    data_ = inline_;
+    size_ = 0;
+    cls_ = kInline;
+}
+
+} // namespace swiftwire
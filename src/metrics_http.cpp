@@ -0,0 +1,113 @@
+#include "metrics_http.hpp"
+#include "swiftwire/server_metrics.hpp"
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace swiftwire {
+using boost::asio::ip::tcp;
+namespace {
+
+constexpr std::size_t kMaxRequest = 8u << 10;
+constexpr auto kRequestTimeout = std::chrono::seconds(5);
+
+class Exchange : public std::enable_shared_from_this<Exchange> {
+public:
+    explicit Exchange(tcp::socket socket)
+        : socket_(std::move(socket)), timer_(socket_.get_executor()), request_(kMaxRequest) {}
+
+    void start() {
+        auto self = shared_from_this();
+        timer_.expires_after(kRequestTimeout);
+        timer_.async_wait([self](const boost::system::error_code& ec) {
+            if (!ec) self->close();
+        });
+        boost::asio::async_read_until(socket_, request_, "\r\n\r\n",
+            [self](const boost::system::error_code& ec, std::size_t) {
+                if (ec) return self->close();
+                self->respond();
+            });
+    }
+
+private:
+    void respond() {
+        const auto data = request_.data();
+        const std::string_view req(static_cast<const char*>(data.data()), data.size());
+        const std::string_view line = req.substr(0, req.find("\r\n"));
+
+        if (line.rfind("GET /metrics ", 0) == 0 || line.rfind("GET / ", 0) == 0) {
+            ServerCounters sum;
+            collect_server_counters(sum);
+            const std::string body = render_prometheus(sum);
+            response_ = "HTTP/1.1 200 OK\r\n"
+                        "Content-Type: text/plain; version=0.0.4\r\n"
+                        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                        "Connection: close\r\n\r\n" + body;
+        } else {
+            response_ = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        }
+
+        auto self = shared_from_this();
+        boost::asio::async_write(socket_, boost::asio::buffer(response_),
+            [self](const boost::system::error_code&, std::size_t) { self->close(); });
+    }
+
+    void close() {
+        boost::system::error_code ig;
+        timer_.cancel();
+        socket_.shutdown(tcp::socket::shutdown_both, ig);
+        socket_.close(ig);
+    }
+
+    tcp::socket socket_;
+    boost::asio::steady_timer timer_;
+    boost::asio::streambuf request_;
+    std::string response_;
+};
+
+} // namespace
+
+MetricsHttp::MetricsHttp(boost::asio::io_context& io, const tcp::endpoint& ep)
+    : acceptor_(std::make_shared<tcp::acceptor>(io)) {
+    boost::system::error_code ec;
+    acceptor_->open(ep.protocol(), ec);
+    if (ec) throw boost::system::system_error(ec);
+    acceptor_->set_option(tcp::acceptor::reuse_address(true), ec);
+    if (ec) throw boost::system::system_error(ec);
+    acceptor_->bind(ep, ec);
+    if (ec) throw boost::system::system_error(ec);
+    acceptor_->listen(boost::asio::socket_base::max_listen_connections, ec);
+    if (ec) throw boost::system::system_error(ec);
+}
+
+// Not concurrent with the io_context: a closed acceptor stops any queued accept
+MetricsHttp::~MetricsHttp() {
+    boost::system::error_code ig;
+    acceptor_->close(ig);
+}
+
+void MetricsHttp::start() {
+    boost::asio::post(acceptor_->get_executor(), [a = acceptor_] {
+        if (a->is_open()) do_accept(a);
+    });
+}
+
+void MetricsHttp::stop() {
+    boost::asio::post(acceptor_->get_executor(), [a = acceptor_] {
+        boost::system::error_code ig;
+        a->close(ig);
+    });
+}
+
+void MetricsHttp::do_accept(std::shared_ptr<tcp::acceptor> acceptor) {
+    // A strand per exchange: its timer and I/O may complete on different threads in shared mode
+    auto ex = boost::asio::make_strand(acceptor->get_executor());
+    auto& a = *acceptor;
+    a.async_accept(ex, [acceptor = std::move(acceptor)](const boost::system::error_code& ec, tcp::socket socket) mutable {
+        if (ec == boost::asio::error::operation_aborted || !acceptor->is_open()) return;
+        if (!ec) std::make_shared<Exchange>(std::move(socket))->start();
+        do_accept(std::move(acceptor));
+    });
+}
+
+} // namespace swiftwire
@@ -0,0 +1,26 @@
+#pragma once
+#include <boost/asio.hpp>
+#include <memory>
+
+namespace swiftwire {
+
+// Minimal HTTP/1.x listener answering `GET /metrics` with the summed
+// ServerCounters in Prometheus text format; one request per connection.
+// Accept completions co-own the acceptor, so the listener may be destroyed
+// while one is still queued on a caller's io_context.
+class MetricsHttp {
+public:
+    MetricsHttp(boost::asio::io_context& io, const boost::asio::ip::tcp::endpoint& ep);
+    ~MetricsHttp();
+
+    void start();  // post the first accept; call once
+    void stop();   // close the listener (posted to its executor)
+    boost::asio::ip::tcp::endpoint local_endpoint() const { return acceptor_->local_endpoint(); }
+
+private:
+    static void do_accept(std::shared_ptr<boost::asio::ip::tcp::acceptor> acceptor);
+
+    std::shared_ptr<boost::asio::ip::tcp::acceptor> acceptor_;
+};
+
+} // namespace swiftwire
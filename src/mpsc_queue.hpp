@@ -0,0 +1,102 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace swiftwire {
+
+// Lock-free multi-producer, single-consumer queue. Producers push with one
+// CAS onto an intrusive stack; the consumer detaches the whole stack with one
+// exchange and reverses it, so each producer's items come out in the order
+// it pushed them. push() reports whether the queue was empty, letting the
+// producer that starts a batch be the only one to wake the consumer.
+//
+// Drained nodes are parked in a few spare slots that producers take from,
+// so a queue whose batches fit in them never allocates once warm. A slot
+// changes hands only by exchange or by CAS from empty, which cannot suffer
+// ABA the way popping a shared free list would.
+template <typename T>
+class MpscQueue {
+public:
+    static constexpr std::size_t spare_nodes = 8;
+
+    MpscQueue() = default;
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+    ~MpscQueue() {
+        drain([](T&&) {});
+        release();
+    }
+
+    // Any thread. True when this item started a new batch.
+    bool push(T value) {
+        Node* node = take_spare();
+        if (!node) node = new Node;
+        node->value.emplace(std::move(value));
+        Node* head = head_.load(std::memory_order_relaxed);
+        do {
+            node->next = head;
+        } while (!head_.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+        return head == nullptr; // not node->next: the consumer may already own the node
+    }
+
+    // Consumer only: hand every queued item to f in FIFO order; returns the count
+    template <typename F>
+    std::size_t drain(F&& f) {
+        Node* list = head_.exchange(nullptr, std::memory_order_acquire);
+        Node* fifo = nullptr;
+        while (list) {
+            Node* next = list->next;
+            list->next = fifo;
+            fifo = list;
+            list = next;
+        }
+        std::size_t n = 0;
+        while (fifo) {
+            Node* next = fifo->next;
+            f(std::move(*fifo->value));
+            fifo->value.reset();
+            recycle(fifo);
+            fifo = next;
+            ++n;
+        }
+        return n;
+    }
+
+    bool empty() const noexcept { return head_.load(std::memory_order_acquire) == nullptr; }
+
+    // Free the spare nodes (e.g. while the consumer is idle); pushes after
+    // this allocate again until the spares are warm
+    void release() noexcept {
+        for (auto& slot : spare_)
+            delete slot.exchange(nullptr, std::memory_order_acquire);
+    }
+
+private:
+    struct Node {
+        std::optional<T> value;
+        Node* next = nullptr;
+    };
+
+    Node* take_spare() noexcept {
+        for (auto& slot : spare_)
+            if (slot.load(std::memory_order_relaxed))
+                if (Node* node = slot.exchange(nullptr, std::memory_order_acquire)) return node;
+        return nullptr;
+    }
+
+    void recycle(Node* node) noexcept {
+        for (auto& slot : spare_) {
+            Node* empty = nullptr;
+            if (slot.compare_exchange_strong(empty, node, std::memory_order_release, std::memory_order_relaxed))
+                return;
+        }
+        delete node;
+    }
+
+    std::atomic<Node*> head_{nullptr};
+    std::array<std::atomic<Node*>, spare_nodes> spare_{};
+};
+
+} // namespace swiftwire
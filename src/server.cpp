@@ -1,160 +1,1082 @@
 #include "swiftwire/server.hpp"
+#include "swiftwire/client_registry.hpp"
+#include "swiftwire/fragment.hpp"
+#include "swiftwire/frame_buffer.hpp"
 #include "swiftwire/protocol.hpp"
+#include "swiftwire/recv_buffer.hpp"
+#include "swiftwire/server_metrics.hpp"
+#include "swiftwire/stage_metrics.hpp"
+#include "swiftwire/write_queue.hpp"
+#include "admission.hpp"
+#include "metrics_http.hpp"
+#include "mpsc_queue.hpp"
+#include "timer_wheel.hpp"
 #include <boost/asio/signal_set.hpp>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#if defined(__linux__)
+#include <pthread.h>
+#endif
 
 namespace swiftwire {
 namespace proto = swiftwire::proto;
 
-class AsyncServer::Session : public std::enable_shared_from_this<Session> {
+namespace {
+
+// What callers hand to send()/broadcast(): at least a length prefix and a type.
+// Anything shorter would be read past its end when queued or fragmented.
+bool whole_frame(std::size_t size) noexcept {
+    return size >= 4 + 1;
+}
+
+} // namespace
+
+// Intrusive list of the sessions on one shard, walked for fan-out. The mutex
+// is uncontended when the shard owns its thread; in shared-reactor mode
+// sessions on different strands join and leave concurrently.
+class SessionList {
+public:
+    struct Hook {
+        Hook* prev = nullptr;
+        Hook* next = nullptr;
+        bool linked = false;
+    };
+
+    void add(Hook& h) {
+        std::lock_guard<std::mutex> lk(mu_);
+        h.prev = nullptr;
+        h.next = head_;
+        if (head_) head_->prev = &h;
+        head_ = &h;
+        h.linked = true;
+    }
+
+    void remove(Hook& h) {
+        std::lock_guard<std::mutex> lk(mu_);
+        if (!h.linked) return;
+        if (h.prev) h.prev->next = h.next;
+        else head_ = h.next;
+        if (h.next) h.next->prev = h.prev;
+        h.linked = false;
+    }
+
+    template <typename F>
+    void for_each(F&& f) {
+        std::lock_guard<std::mutex> lk(mu_);
+        for (Hook* h = head_; h; h = h->next) f(*h);
+    }
+
+private:
+    std::mutex mu_;
+    Hook* head_ = nullptr;
+};
+
+// Topic -> subscribed sessions on one shard, locked like SessionList. A
+// publish only visits the shards that have any subscription at all.
+class TopicMap {
 public:
-    Session(tcp::socket socket, const ServerConfig& cfg)
-        : socket_(std::move(socket)), timer_(socket_.get_executor()), cfg_(cfg) {}
+    using Session = AsyncServer::Session;
+
+    bool subscribe(std::string_view topic, Session* s) {
+        std::lock_guard<std::mutex> lk(mu_);
+        auto it = topics_.find(topic);
+        if (it == topics_.end()) {
+            it = topics_.emplace(std::string(topic), std::vector<Session*>{}).first;
+            topic_count_.store(topics_.size(), std::memory_order_relaxed);
+        }
+        auto& subs = it->second;
+        if (std::find(subs.begin(), subs.end(), s) != subs.end()) return false;
+        subs.push_back(s);
+        return true;
+    }
+
+    void unsubscribe(std::string_view topic, Session* s) {
+        std::lock_guard<std::mutex> lk(mu_);
+        auto it = topics_.find(topic);
+        if (it == topics_.end()) return;
+        auto& subs = it->second;
+        if (auto pos = std::find(subs.begin(), subs.end(), s); pos != subs.end()) {
+            *pos = subs.back();
+            subs.pop_back();
+        }
+        if (subs.empty()) {
+            topics_.erase(it);
+            topic_count_.store(topics_.size(), std::memory_order_relaxed);
+        }
+    }
+
+    template <typename F>
+    void for_each(std::string_view topic, F&& f) {
+        std::lock_guard<std::mutex> lk(mu_);
+        auto it = topics_.find(topic);
+        if (it == topics_.end()) return;
+        for (Session* s : it->second) f(*s);
+    }
+
+    bool empty() const noexcept { return topic_count_.load(std::memory_order_relaxed) == 0; }
+
+private:
+    struct Hash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view s) const noexcept { return std::hash<std::string_view>{}(s); }
+    };
+
+    std::mutex mu_;
+    std::unordered_map<std::string, std::vector<Session*>, Hash, std::equal_to<>> topics_;
+    std::atomic<std::size_t> topic_count_{0};
+};
+
+// Everything a shard's sessions refer to: the server's config and client
+// registry, and the shard's session list, topics and idle wheel. Sessions
+// co-own it with the server, so one destroyed after the server (left in the
+// caller's io_context in shared-reactor mode) still unlinks itself safely.
+struct ShardCore {
+    ShardCore(std::shared_ptr<const ServerConfig> c, std::shared_ptr<ClientRegistry> r)
+        : cfg(std::move(c)), clients(std::move(r)) {}
+
+    std::shared_ptr<const ServerConfig> cfg;
+    std::shared_ptr<ClientRegistry> clients;
+    SessionList sessions;                // every session started on this shard
+    TopicMap topics;                     // pub/sub subscriptions of those sessions
+    std::unique_ptr<TimerWheel> wheel;   // idle_timer_wheel mode
+    std::optional<boost::asio::steady_timer> sweep;  // advances the wheel; reset with the shard
+    std::atomic<bool> detached{false};   // the server is gone: dispatch and admit nothing more
+
+    // One wheel tick per expiry; a completion already queued when the server
+    // went away finds the core detached and stops
+    static void start_sweep(const std::shared_ptr<ShardCore>& core) {
+        core->sweep->expires_after(core->wheel->tick());
+        core->sweep->async_wait([core](const boost::system::error_code& ec) {
+            if (ec || core->detached.load(std::memory_order_relaxed)) return;
+            core->wheel->advance();
+            start_sweep(core);
+        });
+    }
+};
+
+class AsyncServer::Session : public std::enable_shared_from_this<Session>,
+                             private TimerWheel::Entry,
+                             private SessionList::Hook {
+public:
+    Session(tcp::socket socket, std::shared_ptr<ShardCore> shard, const MessageRouter& router,
+            Admission::Slot slot)
+        : shard_(std::move(shard)), socket_(std::move(socket)), cfg_(*shard_->cfg), router_(router),
+          wheel_(shard_->wheel.get()), clients_(*shard_->clients), sessions_(shard_->sessions),
+          topics_(shard_->topics), slot_(std::move(slot)),
+          rbuf_(cfg_.recv_buffer_size, cfg_.low_footprint),
+          max_iov_(std::clamp<std::size_t>(cfg_.max_write_batch_iov, 1, WriteQueue::max_iov)) {
+        if (!wheel_) timer_.emplace(socket_.get_executor());
+        if (cfg_.metrics) ServerCounters::add(local_server_counters().sessions_accepted);
+    }
+
+    ~Session() {
+        sessions_.remove(*this);
+        for (auto& topic : subscriptions_) topics_.unsubscribe(topic, this);
+        if (wheel_) wheel_->remove(*this);
+        if (client_id_) clients_.erase(*client_id_, this);
+        if (cfg_.metrics) {
+            auto& m = local_server_counters();
+            ServerCounters::add(m.sessions_closed);
+            ServerCounters::sub(m.write_queue_bytes, write_queue_.bytes());
+        }
+    }
 
     void start() {
         boost::system::error_code ec;
         if (cfg_.tcp_nodelay) socket_.set_option(tcp::no_delay(true), ec);
-        refresh_timer();
-        read_len();
+        if (wheel_) wheel_->add(*this);
+        sessions_.add(*this);
+        do_read();
+    }
+
+    static Session& from_hook(SessionList::Hook& hook) { return static_cast<Session&>(hook); }
+
+    // Runs on the sweeping thread under the wheel lock: hop to our own executor
+    static void on_idle(TimerWheel::Entry* entry) {
+        auto* session = static_cast<Session*>(entry);
+        if (auto self = session->weak_from_this().lock()) {
+            boost::asio::post(session->socket_.get_executor(), [self] {
+                self->fail_and_close(boost::asio::error::timed_out);
+            });
+        }
+    }
+
+    void enqueue_write(FrameBuffer buf, uint64_t key = 0) {
+        bool idle = write_queue_.empty();
+        if (queue_frame(std::move(buf), key) && idle) do_write();
+    }
+
+    // Any thread: park the frame in the inbox; the producer that starts a
+    // batch posts the single drain that moves it onto the write queue
+    void send_from_any_thread(FrameBuffer buf, uint64_t key = 0) {
+        if (inbox_.push(Outbound{std::move(buf), key}))
+            boost::asio::post(socket_.get_executor(), [self = shared_from_this()] { self->drain_inbox(); });
+    }
+
+    bool closed() const noexcept { return closed_.load(std::memory_order_relaxed); }
+
+    // HELLO: route `id` here; a connection already holding it is closed
+    void register_client(uint64_t id) {
+        if (client_id_ == id || closed_) return;
+        if (client_id_) clients_.erase(*client_id_, this);
+        client_id_ = id;
+        clients_.insert(id, SessionHandle(weak_from_this()), this).close();
+    }
+
+    void subscribe(std::string_view topic) {
+        if (closed_ || !topics_.subscribe(topic, this)) return;
+        subscriptions_.emplace_back(topic);
+    }
+
+    void unsubscribe(std::string_view topic) {
+        auto it = std::find(subscriptions_.begin(), subscriptions_.end(), topic);
+        if (it == subscriptions_.end()) return;
+        topics_.unsubscribe(topic, this);
+        *it = std::move(subscriptions_.back());
+        subscriptions_.pop_back();
+    }
+
+    // A pub/sub MESSAGE, on our executor. Past the high watermark this
+    // subscriber is not keeping up: skip it rather than queue towards the
+    // hard cap, which would disconnect it. Conflating sessions keep at most
+    // one unsent MESSAGE per topic, so they take the newest one instead.
+    void deliver(const SharedFrame& message, uint64_t topic_key) {
+        if (closed_) return;
+        if (cfg_.conflate_writes) return enqueue_write(FrameBuffer(message), topic_key);
+        if (write_queue_.bytes() >= cfg_.write_high_watermark) {
+            if (cfg_.metrics) ServerCounters::add(local_server_counters().pubsub_dropped);
+            return;
+        }
+        enqueue_write(FrameBuffer(message));
+    }
+
+    boost::asio::any_io_executor get_executor() { return socket_.get_executor(); }
+
+    void fail_and_close(const boost::system::error_code& ec) {
+        if (closed_.exchange(true)) return;
+        cancel_timer();
+        boost::system::error_code ig;
+        socket_.shutdown(tcp::socket::shutdown_both, ig);
+        socket_.close(ig);
+        if (client_id_) clients_.erase(*client_id_, this);
+        if (cfg_.metrics)
+            ServerCounters::add(local_server_counters().closes[static_cast<std::size_t>(classify_close(ec))]);
+    }
+
+    // MessageContext::pause_reading()/resume_reading()
+    void hold_reading(bool hold) {
+        read_held_ = hold;
+        if (!hold && read_paused_ && !closed_) resume_reading();
     }
 
 private:
+    // Hard cap check, metrics and push; false once the session had to close
+    bool queue_frame(FrameBuffer buf, uint64_t key) {
+        if (write_queue_.bytes() + buf.size() > cfg_.max_write_queue_bytes) {
+            fail_and_close(boost::asio::error::no_buffer_space);
+            return false;
+        }
+        uint64_t stamp = 0;
+        if (cfg_.stage_metrics) {
+            auto& m = local_stage_metrics();
+            stamp = stage_clock_ns();
+            if (dispatch_ns_) m[Stage::dispatch_to_enqueue].record(stamp - dispatch_ns_);
+            m[Stage::queue_depth].record(write_queue_.size());
+        }
+        const uint8_t type = frame_type(buf);
+        if (cfg_.fragment_size && buf.size() - 4 > cfg_.fragment_size) {
+            std::size_t queued = 0;
+            fragment_body(buf.data() + 4, buf.size() - 4, cfg_.fragment_size, next_stream_++, [&](FrameBuffer frag) {
+                queued += frag.size();
+                write_queue_.push(std::move(frag), stamp, 0, WriteQueue::fragment);
+            });
+            if (cfg_.metrics) count_out(type, queued);
+            return true;
+        }
+        if (cfg_.metrics) count_out(type, buf.size());
+        const auto lane = (type == proto::MSG_HELLO_ACK || cfg_.control_types[type]) ? WriteQueue::control
+                                                                                      : WriteQueue::bulk;
+        const std::size_t displaced =
+            write_queue_.push(std::move(buf), stamp, cfg_.conflate_writes ? key : 0, lane);
+        if (displaced && cfg_.metrics) {
+            auto& m = local_server_counters();
+            ServerCounters::add(m.frames_conflated);
+            ServerCounters::sub(m.write_queue_bytes, displaced);
+        }
+        return true;
+    }
+
+    // The whole batch joins the write queue before a single writev is started
+    void drain_inbox() {
+        const bool idle = write_queue_.empty();
+        bool open = !closed_;
+        inbox_.drain([&](Outbound&& out) {
+            if (open) open = queue_frame(std::move(out.buf), out.key);
+        });
+        if (open && idle) do_write();
+    }
+
     void refresh_timer() {
-        timer_.expires_after(cfg_.idle_timeout);
+        if (wheel_) return wheel_->touch(*this);
+        timer_->expires_after(cfg_.idle_timeout);
         auto self = shared_from_this();
-        timer_.async_wait([self](const boost::system::error_code& ec) {
+        timer_->async_wait([self](const boost::system::error_code& ec) {
             if (ec == boost::asio::error::operation_aborted) return;
             self->fail_and_close(boost::asio::error::timed_out);
         });
     }
     void cancel_timer() {
+        if (wheel_) return wheel_->remove(*this);
         // boost::system::error_code ig;
         // timer_.cancel(ig);
-        timer_.cancel(); // modern Boost: no error_code overload
+        timer_->cancel(); // modern Boost: no error_code overload
     }
 
-    void read_len() {
-        auto self = shared_from_this();
+    // One async_read_some fills the receive buffer; every complete frame in it
+    // is dispatched before the next read is issued. Parsing and reading stop
+    // while the write queue is above the high watermark, letting TCP flow
+    // control push back on the peer, and resume once it drains to the low one.
+    //
+    // In low_footprint mode an idle session waits for readability without a
+    // buffer and only borrows one from the pool for the read itself.
+    void do_read() {
         refresh_timer();
-        boost::asio::async_read(socket_, boost::asio::buffer(lenbuf_),
-            [self](auto ec, std::size_t) {
-                if (ec) return self->fail_and_close(ec);
-                uint32_t blen = proto::read_u32be(self->lenbuf_.data());
-                if (blen == 0 || blen > self->cfg_.max_frame)
-                    return self->fail_and_close(boost::asio::error::message_size);
-                self->body_.resize(blen);
-                self->read_body();
-            });
+        if (!cfg_.low_footprint || rbuf_.size() > 0) return read_some();
+        rbuf_.release();
+        socket_.async_wait(tcp::socket::wait_read, [self = shared_from_this()](auto ec) {
+            if (ec) return self->fail_and_close(ec);
+            self->read_some();
+        });
     }
-    void read_body() {
+
+    void read_some() {
         auto self = shared_from_this();
-        refresh_timer();
-        boost::asio::async_read(socket_, boost::asio::buffer(body_),
-            [self](auto ec, std::size_t) {
+        socket_.async_read_some(rbuf_.prepare(read_hint_),
+            [self](auto ec, std::size_t n) {
                 if (ec) return self->fail_and_close(ec);
-                self->handle_message();
-                self->read_len();
+                if (self->cfg_.stage_metrics) self->read_done_ns_ = stage_clock_ns();
+                if (self->cfg_.metrics) ServerCounters::add(local_server_counters().bytes_in, n);
+                self->rbuf_.commit(n);
+                if (self->parse_frames()) self->do_read();
             });
     }
 
-    void handle_message() {
-        cancel_timer();
-        if (body_.empty()) return;
-
-        uint8_t type = static_cast<uint8_t>(body_[0]);
-        switch (type) {
-            case proto::MSG_HELLO: {
-                if (body_.size() < 1 + 8) return; // ignore malformed
-                uint64_t client_id = proto::read_u64be(body_.data() + 1);
-                send_hello_ack(client_id, /*status=*/0);
-                break;
+    bool parse_frames() {
+        read_hint_ = 1;
+        if (closed_ || shard_->detached.load(std::memory_order_relaxed)) return false;
+        for (;;) {
+            if (read_held_) {
+                read_paused_ = true;
+                return false;
             }
-            default: {
-                if (body_.size() >= 1 + 8) {
-                    uint64_t maybe_id = proto::read_u64be(body_.data() + 1);
-                    send_hello_ack(maybe_id, /*status=*/1);
+            // Checked before the buffer runs dry, so no read is issued over the mark
+            if (write_queue_.bytes() >= cfg_.write_high_watermark) {
+                read_paused_ = true;
+                if (cfg_.metrics) ServerCounters::add(local_server_counters().backpressure_pauses);
+                return false;
+            }
+            if (in_stream_ ? rbuf_.size() == 0 : rbuf_.size() < 4) break;
+            if (in_stream_) {
+                const std::size_t n = std::min(rbuf_.size(), stream_.total - stream_.offset);
+                deliver_chunk(rbuf_.data(), n);
+                rbuf_.consume(n);
+                if (closed_) return false;
+                continue;
+            }
+            uint32_t blen = proto::read_u32be(rbuf_.data());
+            if (blen == 0) {
+                fail_and_close(boost::asio::error::message_size);
+                return false;
+            }
+            if (router_.has_streams()) {
+                const int streamed = begin_stream(blen);
+                if (streamed < 0) break;      // type not known yet
+                if (streamed > 0) {
+                    if (closed_) return false;
+                    continue;
                 }
+            }
+            if (blen > cfg_.max_frame) {
+                fail_and_close(boost::asio::error::message_size);
+                return false;
+            }
+            if (rbuf_.size() - 4 < blen) {
+                read_hint_ = 4 + blen - rbuf_.size(); // make room for the rest of this frame
                 break;
             }
+            handle_message(rbuf_.data() + 4, blen);
+            rbuf_.consume(4 + blen);
+            if (closed_) return false;
         }
+        if (rbuf_.size() == 0) rbuf_.shrink();
+        return true;
     }
 
-    void send_hello_ack(uint64_t id, uint8_t status) {
-        constexpr std::size_t body_len = 1 + 8 + 1;
-        auto buf = std::make_shared<std::vector<char>>(4 + body_len);
-        proto::write_u32be(buf->data(), static_cast<uint32_t>(body_len));
-        (*buf)[4] = static_cast<char>(proto::MSG_HELLO_ACK);
-        proto::write_u64be(buf->data() + 5, id);
-        (*buf)[13] = static_cast<char>(status);
-        enqueue_write(std::move(buf));
+    // A frame whose type has an on_stream handler is never buffered whole:
+    // its header is consumed here and parse_frames() hands the payload over
+    // in whatever pieces the reads bring in. 1 when the frame at the head of
+    // the buffer is streamed, 0 when not, -1 when its type is not in yet.
+    int begin_stream(uint32_t blen) {
+        const std::size_t avail = rbuf_.size() - 4;
+        if (avail == 0) return -1;
+        const char* body = rbuf_.data() + 4;
+        const bool wrapped = static_cast<uint8_t>(body[0]) == proto::MSG_REQUEST && blen >= proto::ENVELOPE_LEN;
+        if (wrapped && avail < proto::ENVELOPE_LEN) {
+            read_hint_ = proto::ENVELOPE_LEN - avail;
+            return -1;
+        }
+        const uint8_t type = static_cast<uint8_t>(body[wrapped ? proto::ENVELOPE_LEN - 1 : 0]);
+        if (!router_.streams(type)) return 0;
+        if (blen > cfg_.max_stream_frame) {
+            fail_and_close(boost::asio::error::message_size);
+            return 1;
+        }
+        const std::size_t header = wrapped ? proto::ENVELOPE_LEN : 1;
+        stream_ = InStream{type, wrapped, wrapped ? proto::read_u32be(body + 1) : 0u, blen - header, 0};
+        in_stream_ = true;
+        rbuf_.consume(4 + header);
+        if (cfg_.metrics) ServerCounters::add(local_server_counters().frames_in[type]);
+        if (stream_.total == 0) deliver_chunk(nullptr, 0);
+        return 1;
     }
 
-    void enqueue_write(std::shared_ptr<std::vector<char>> buf) {
-        pending_bytes_ += buf->size();
-        if (pending_bytes_ > cfg_.max_write_queue_bytes)
-            return fail_and_close(boost::asio::error::no_buffer_space);
-        bool idle = write_queue_.empty();
-        write_queue_.push_back(std::move(buf));
-        if (idle) do_write();
+    void deliver_chunk(const char* data, std::size_t n) {
+        MessageContext ctx(*this);
+        ctx.corr_id_ = stream_.corr_id;
+        ctx.correlated_ = stream_.correlated;
+        const StreamChunk chunk{stream_.type, data, n, stream_.offset, stream_.total};
+        stream_.offset += n;
+        in_stream_ = stream_.offset < stream_.total;
+        router_.dispatch(ctx, chunk);
+    }
+
+    void resume_reading() {
+        read_paused_ = false;
+        if (parse_frames()) do_read();
+    }
+
+    void handle_message(const char* body, std::size_t len) {
+        if (static_cast<uint8_t>(body[0]) == proto::MSG_FRAGMENT) {
+            auto on_message = [this](const char* msg, std::size_t n) {
+                if (static_cast<uint8_t>(msg[0]) != proto::MSG_FRAGMENT) handle_message(msg, n);
+            };
+            const std::size_t limit = cfg_.max_message ? cfg_.max_message : cfg_.max_frame;
+            const bool ok = reassembler_.add(body + 1, len - 1, limit, on_message);
+            if (!ok) fail_and_close(boost::asio::error::message_size);
+            return;
+        }
+        MessageContext ctx(*this);
+        Message msg{static_cast<uint8_t>(body[0]), body + 1, len - 1};
+        if (msg.type == proto::MSG_REQUEST) {
+            if (len < proto::ENVELOPE_LEN) return; // ignore malformed
+            ctx.corr_id_ = proto::read_u32be(body + 1);
+            ctx.correlated_ = true;
+            msg = Message{static_cast<uint8_t>(body[5]), body + proto::ENVELOPE_LEN, len - proto::ENVELOPE_LEN};
+        }
+        if (cfg_.metrics) ServerCounters::add(local_server_counters().frames_in[msg.type]);
+        if (router_.streams(msg.type)) // reassembled from FRAGMENTs: one chunk
+            return router_.dispatch(ctx, StreamChunk{msg.type, msg.data, msg.size, 0, msg.size});
+        if (!cfg_.stage_metrics) return router_.dispatch(ctx, msg);
+
+        dispatch_ns_ = stage_clock_ns();
+        local_stage_metrics()[Stage::read_to_dispatch].record(dispatch_ns_ - read_done_ns_);
+        router_.dispatch(ctx, msg);
+        dispatch_ns_ = 0;
     }
 
+    // Submit as much of the queue as the batch caps allow in one writev, then
+    // retire whatever was fully written; a partially written entry stays at
+    // the head and leads the next batch.
     void do_write() {
         if (write_queue_.empty()) return;
         auto self = shared_from_this();
         refresh_timer();
-        auto& front = write_queue_.front();
-        boost::asio::async_write(socket_, boost::asio::buffer(*front),
+        socket_.async_write_some(write_queue_.gather(iov_, max_iov_, cfg_.max_write_batch_bytes),
             [self](auto ec, std::size_t n) {
-                self->pending_bytes_ -= std::min<std::size_t>(n, self->write_queue_.front()->size());
-                self->write_queue_.pop_front();
                 if (ec) return self->fail_and_close(ec);
+                self->retire_written(n);
                 if (!self->write_queue_.empty()) self->do_write();
+                else if (self->cfg_.low_footprint) self->release_write_storage();
+                if (self->read_paused_ && self->write_queue_.bytes() <= self->cfg_.write_low_watermark)
+                    self->resume_reading();
             });
     }
 
-    void fail_and_close(const boost::system::error_code& ec) {
-        if (closed_.exchange(true)) return;
-        cancel_timer();
-        boost::system::error_code ig;
-        socket_.shutdown(tcp::socket::shutdown_both, ig);
-        socket_.close(ig);
-        (void)ec; // optionally log
+    void release_write_storage() {
+        write_queue_.release();
+        inbox_.release();
+        std::vector<boost::asio::const_buffer>().swap(iov_);
+    }
+
+    void retire_written(std::size_t n) {
+        if (cfg_.metrics) {
+            auto& m = local_server_counters();
+            ServerCounters::add(m.bytes_out, n);
+            ServerCounters::sub(m.write_queue_bytes, n);
+        }
+        if (!cfg_.stage_metrics) return write_queue_.consume(n);
+        auto& h = local_stage_metrics()[Stage::enqueue_to_write];
+        const uint64_t now = stage_clock_ns();
+        write_queue_.consume(n, [&](uint64_t stamp) { h.record(now - stamp); });
+    }
+
+    // Message type for metrics and lanes: the inner type when wrapped in a RESPONSE envelope
+    static uint8_t frame_type(const FrameBuffer& buf) {
+        uint8_t type = static_cast<uint8_t>(buf.data()[4]);
+        if (type == proto::MSG_RESPONSE && buf.size() >= 4 + proto::ENVELOPE_LEN)
+            type = static_cast<uint8_t>(buf.data()[4 + proto::ENVELOPE_LEN - 1]);
+        return type;
+    }
+
+    static void count_out(uint8_t type, std::size_t size) {
+        auto& m = local_server_counters();
+        ServerCounters::add(m.frames_out[type]);
+        ServerCounters::add(m.write_queue_bytes, size);
     }
 
 private:
+    std::shared_ptr<ShardCore> shard_;                 // keeps the references below valid
     tcp::socket socket_;
-    boost::asio::steady_timer timer_;
-    const ServerConfig cfg_;
+    std::optional<boost::asio::steady_timer> timer_;   // idle timeout unless the shard has a wheel
+    const ServerConfig& cfg_;
+    const MessageRouter& router_;                      // the server's: not used once detached
+    TimerWheel* wheel_;
+    ClientRegistry& clients_;
+    SessionList& sessions_;
+    TopicMap& topics_;
+    std::vector<std::string> subscriptions_;
+    std::optional<uint64_t> client_id_;
+    Admission::Slot slot_;       // counts towards the admission limits until destroyed
 
-    std::array<char, 4> lenbuf_{};
-    std::vector<char> body_;
-    std::deque<std::shared_ptr<std::vector<char>>> write_queue_;
-    std::size_t pending_bytes_{0};
+    RecvBuffer rbuf_;
+    std::size_t read_hint_{1};
+    bool read_paused_{false};
+    bool read_held_{false};      // by the application, see hold_reading()
+    struct InStream {
+        uint8_t type;
+        bool correlated;
+        uint32_t corr_id;
+        std::size_t total;
+        std::size_t offset;
+    };
+    InStream stream_{};          // the frame being streamed while in_stream_
+    bool in_stream_{false};
+    Reassembler reassembler_;    // FRAGMENTs received
+    uint32_t next_stream_{1};    // FRAGMENT stream ids sent
+    uint64_t read_done_ns_{0};   // stage_metrics timestamps
+    uint64_t dispatch_ns_{0};
+    WriteQueue write_queue_;
+    const std::size_t max_iov_;
+    std::vector<boost::asio::const_buffer> iov_;
+    struct Outbound {
+        FrameBuffer buf;
+        uint64_t key;
+    };
+    MpscQueue<Outbound> inbox_;      // frames sent through a SessionHandle
     std::atomic<bool> closed_{false};
 };
 
-AsyncServer::AsyncServer(boost::asio::io_context& io, const tcp::endpoint& ep, ServerConfig cfg)
-    : io_(io), acceptor_(io), cfg_(cfg) {
+void MessageContext::send(FrameBuffer frame, uint64_t conflation_key) {
+    if (!whole_frame(frame.size()))
+        throw boost::system::system_error(make_error_code(boost::asio::error::invalid_argument));
+    session_.enqueue_write(std::move(frame), conflation_key);
+}
+
+void MessageContext::reply(uint8_t type, const void* payload, std::size_t size) {
+    if (!correlated_) {
+        auto buf = FrameBuffer::frame(type, size);
+        if (size) std::memcpy(buf.payload(), payload, size);
+        return session_.enqueue_write(std::move(buf));
+    }
+    auto buf = FrameBuffer::frame(proto::MSG_RESPONSE, 4 + 1 + size);
+    proto::write_u32be(buf.payload(), corr_id_);
+    buf.payload()[4] = static_cast<char>(type);
+    if (size) std::memcpy(buf.payload() + 5, payload, size);
+    session_.enqueue_write(std::move(buf));
+}
+
+void MessageContext::close() {
+    session_.fail_and_close(boost::asio::error::shut_down);
+}
+
+SessionHandle MessageContext::handle() const {
+    return SessionHandle(session_.weak_from_this());
+}
+
+bool SessionHandle::send(FrameBuffer frame, uint64_t conflation_key) const {
+    if (!whole_frame(frame.size())) return false;
+    auto session = session_.lock();
+    if (!session || session->closed()) return false;
+    session->send_from_any_thread(std::move(frame), conflation_key);
+    return true;
+}
+
+bool SessionHandle::send(uint8_t type, const void* payload, std::size_t size) const {
+    auto buf = FrameBuffer::frame(type, size);
+    if (size) std::memcpy(buf.payload(), payload, size);
+    return send(std::move(buf));
+}
+
+void SessionHandle::close() const {
+    if (auto session = session_.lock()) {
+        boost::asio::post(session->get_executor(), [session] {
+            session->fail_and_close(boost::asio::error::shut_down);
+        });
+    }
+}
+
+MessageContext MessageContext::retain() const {
+    MessageContext copy(*this);
+    if (!copy.keepalive_) copy.keepalive_ = session_.shared_from_this();
+    return copy;
+}
+
+boost::asio::any_io_executor MessageContext::get_executor() const {
+    return session_.get_executor();
+}
+
+void MessageContext::pause_reading() {
+    session_.hold_reading(true);
+}
+
+void MessageContext::resume_reading() {
+    session_.hold_reading(false);
+}
+
+namespace {
+
+void send_hello_ack(MessageContext& ctx, uint64_t id, uint8_t status) {
+    char ack[8 + 1];
+    proto::write_u64be(ack, id);
+    ack[8] = static_cast<char>(status);
+    ctx.reply(proto::MSG_HELLO_ACK, ack, sizeof(ack));
+}
+
+// Unknown types are answered with a HELLO_ACK carrying status 1, or an
+// ERROR response when the sender is waiting on a correlation id
+void handle_unknown(MessageContext& ctx, const Message& msg) {
+    if (ctx.correlated()) {
+        const char status = 1;
+        return ctx.reply(proto::MSG_ERROR, &status, 1);
+    }
+    if (msg.size < 8) return;
+    send_hello_ack(ctx, proto::read_u64be(msg.data), /*status=*/1);
+}
+
+} // namespace
+
+struct AsyncServer::Shard {
+    // Non-owning: sessions share the caller's io_context and get a strand each
+    Shard(boost::asio::io_context& external, std::shared_ptr<ShardCore> c)
+        : core(std::move(c)), sessions(core->sessions), topics(core->topics), io(&external) {}
+    // Owning: one single-threaded io_context per shard, no strands needed
+    explicit Shard(std::shared_ptr<ShardCore> c)
+        : core(std::move(c)), sessions(core->sessions), topics(core->topics),
+          owned(std::make_unique<boost::asio::io_context>(1)),
+          io(owned.get()),
+          work(boost::asio::make_work_guard(*owned)) {}
+
+    // Sessions still queued in an owned io_context are dropped with it
+    ~Shard() {
+        core->sweep.reset();
+        accept_backoff.reset();
+        acceptor.reset();
+        owned.reset();
+    }
+
+    boost::asio::any_io_executor session_executor() {
+        if (owned) return io->get_executor();
+        return boost::asio::make_strand(*io);
+    }
+
+    std::shared_ptr<ShardCore> core;       // co-owned by the shard's sessions
+    SessionList& sessions;                 // core->sessions
+    TopicMap& topics;                      // core->topics
+    std::unique_ptr<boost::asio::io_context> owned;
+    boost::asio::io_context* io;
+    std::optional<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> work;
+    std::optional<tcp::acceptor> acceptor; // set on listening shards only
+    std::optional<boost::asio::steady_timer> accept_backoff; // with the acceptor
+    std::size_t parked_accepts = 0;        // accepts waiting for accept_backoff to expire
+
+    // Idle-timeout wheel, swept by one coarse timer per shard (idle_timer_wheel mode)
+    void enable_wheel(const ServerConfig& cfg) {
+        core->wheel = std::make_unique<TimerWheel>(cfg.idle_wheel_tick, cfg.idle_timeout, &Session::on_idle);
+        core->sweep.emplace(*io);
+    }
+};
+
+namespace {
+
+// accept() failures that retrying immediately cannot fix
+bool out_of_resources(const boost::system::error_code& ec) noexcept {
+    namespace error = boost::asio::error;
+    return ec == error::no_descriptors || ec == error::no_buffer_space || ec == error::no_memory ||
+           ec == boost::system::errc::too_many_files_open_in_system;
+}
+
+#if defined(SO_REUSEPORT)
+using reuse_port = boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#endif
+
+void open_acceptor(tcp::acceptor& acceptor, const tcp::endpoint& ep, bool reuse) {
     boost::system::error_code ec;
-    acceptor_.open(ep.protocol(), ec);
+    acceptor.open(ep.protocol(), ec);
     if (ec) throw boost::system::system_error(ec);
-    acceptor_.set_option(tcp::acceptor::reuse_address(true), ec);
+    acceptor.set_option(tcp::acceptor::reuse_address(true), ec);
     if (ec) throw boost::system::system_error(ec);
-    acceptor_.bind(ep, ec);
+    if (reuse) {
+#if defined(SO_REUSEPORT)
+        acceptor.set_option(reuse_port(true), ec);
+#else
+        ec = boost::asio::error::operation_not_supported;
+#endif
+        if (ec) throw boost::system::system_error(ec);
+    }
+    acceptor.bind(ep, ec);
     if (ec) throw boost::system::system_error(ec);
-    acceptor_.listen(boost::asio::socket_base::max_listen_connections, ec);
+    acceptor.listen(boost::asio::socket_base::max_listen_connections, ec);
     if (ec) throw boost::system::system_error(ec);
 }
 
+void pin_to_cpu(std::thread& t, std::size_t cpu) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % std::max(1u, std::thread::hardware_concurrency()), &set);
+    pthread_setaffinity_np(t.native_handle(), sizeof(set), &set);
+#else
+    (void)t; (void)cpu;
+#endif
+}
+
+} // namespace
+
+AsyncServer::AsyncServer(boost::asio::io_context& io, const tcp::endpoint& ep, ServerConfig cfg)
+    : clients_(std::make_shared<ClientRegistry>()),
+      admission_(std::make_shared<Admission>(cfg.max_connections, cfg.max_connections_per_ip)),
+      config_(std::make_shared<ServerConfig>(std::move(cfg))), cfg_(*config_), owns_shards_(false) {
+    if (cfg_.low_footprint) cfg_.idle_timer_wheel = true;
+    install_default_handlers();
+    shards_.push_back(std::make_unique<Shard>(io, std::make_shared<ShardCore>(config_, clients_)));
+    if (cfg_.idle_timer_wheel) shards_.front()->enable_wheel(cfg_);
+    open_listeners(ep);
+    open_metrics();
+}
+
+AsyncServer::AsyncServer(const tcp::endpoint& ep, ServerConfig cfg)
+    : clients_(std::make_shared<ClientRegistry>()),
+      admission_(std::make_shared<Admission>(cfg.max_connections, cfg.max_connections_per_ip)),
+      config_(std::make_shared<ServerConfig>(std::move(cfg))), cfg_(*config_), owns_shards_(true) {
+    if (cfg_.low_footprint) cfg_.idle_timer_wheel = true;
+    install_default_handlers();
+    for (std::size_t i = 0; i < std::max<std::size_t>(1, cfg_.threads); ++i)
+        shards_.push_back(std::make_unique<Shard>(std::make_shared<ShardCore>(config_, clients_)));
+    if (cfg_.idle_timer_wheel)
+        for (auto& shard : shards_) shard->enable_wheel(cfg_);
+    open_listeners(ep);
+    open_metrics();
+}
+
+AsyncServer::~AsyncServer() {
+    if (owns_shards_) {
+        stop();
+        join();
+    }
+    for (auto& shard : shards_) shard->core->detached.store(true, std::memory_order_relaxed);
+    if (owns_shards_) return;
+    // The caller's io_context outlives us and may still hold sessions and
+    // handlers queued for them. Detached, they dispatch nothing more; each is
+    // closed on its own executor, and what it unlinks from when destroyed is
+    // co-owned through its ShardCore.
+    for (auto& shard : shards_) {
+        std::vector<std::shared_ptr<Session>> open;
+        shard->sessions.for_each([&](SessionList::Hook& hook) {
+            if (auto session = Session::from_hook(hook).weak_from_this().lock()) open.push_back(std::move(session));
+        });
+        for (auto& session : open) {
+            auto ex = session->get_executor();
+            boost::asio::post(ex, [session = std::move(session)] {
+                session->fail_and_close(boost::asio::error::shut_down);
+            });
+        }
+    }
+}
+
+void AsyncServer::install_default_handlers() {
+    router_.on(proto::MSG_HELLO, [this](MessageContext& ctx, const Message& msg) { handle_hello(ctx, msg); });
+    router_.fallback(&handle_unknown);
+    if (!cfg_.pubsub) return;
+    router_.on(proto::MSG_SUBSCRIBE, [this](MessageContext& ctx, const Message& msg) {
+        handle_subscribe(ctx, msg, true);
+    });
+    router_.on(proto::MSG_UNSUBSCRIBE, [this](MessageContext& ctx, const Message& msg) {
+        handle_subscribe(ctx, msg, false);
+    });
+    router_.on(proto::MSG_PUBLISH, [this](MessageContext& ctx, const Message& msg) { handle_publish(ctx, msg); });
+}
+
+void AsyncServer::handle_hello(MessageContext& ctx, const Message& msg) {
+    if (msg.size < 8) return; // ignore malformed
+    const uint64_t id = proto::read_u64be(msg.data);
+    ctx.session_.register_client(id);
+    send_hello_ack(ctx, id, /*status=*/0);
+}
+
+// SUBSCRIBE / UNSUBSCRIBE: the payload is the topic
+void AsyncServer::handle_subscribe(MessageContext& ctx, const Message& msg, bool subscribe) {
+    if (msg.size > proto::MAX_TOPIC_LEN) return ctx.close();
+    const std::string_view topic(msg.data, msg.size);
+    if (subscribe) ctx.session_.subscribe(topic);
+    else ctx.session_.unsubscribe(topic);
+    if (ctx.correlated()) ctx.reply(msg.type, nullptr, 0);
+}
+
+// PUBLISH: [2B topic_len][topic][data] becomes a MESSAGE with the same payload
+void AsyncServer::handle_publish(MessageContext& ctx, const Message& msg) {
+    if (msg.size < 2 || 2u + proto::read_u16be(msg.data) > msg.size) return; // ignore malformed
+    auto message = SharedFrame::frame(proto::MSG_MESSAGE, msg.size);
+    std::memcpy(message.payload(), msg.data, msg.size);
+    fan_out(message);
+    if (ctx.correlated()) ctx.reply(proto::MSG_PUBLISH, nullptr, 0);
+}
+
+void AsyncServer::open_listeners(tcp::endpoint ep) {
+    // With SO_REUSEPORT every owned shard binds the endpoint itself and the
+    // kernel spreads connections; otherwise shard 0 accepts for everyone.
+    const std::size_t listeners = (cfg_.reuse_port && owns_shards_) ? shards_.size() : 1;
+    for (std::size_t i = 0; i < listeners; ++i) {
+        auto& acceptor = shards_[i]->acceptor.emplace(*shards_[i]->io);
+        shards_[i]->accept_backoff.emplace(*shards_[i]->io);
+        open_acceptor(acceptor, ep, cfg_.reuse_port);
+        ep = acceptor.local_endpoint(); // resolve port 0 once so all listeners share it
+    }
+}
+
+// Served from the first shard: a scrape is rare and only sums per-thread counters
+void AsyncServer::open_metrics() {
+    if (!cfg_.metrics_endpoint) return;
+    cfg_.metrics = true;
+    metrics_http_ = std::make_unique<MetricsHttp>(*shards_.front()->io, *cfg_.metrics_endpoint);
+}
+
+tcp::endpoint AsyncServer::local_endpoint() const {
+    return shards_.front()->acceptor->local_endpoint();
+}
+
+tcp::endpoint AsyncServer::metrics_local_endpoint() const {
+    return metrics_http_->local_endpoint();
+}
+
 void AsyncServer::run() {
-    do_accept();
+    if (metrics_http_) metrics_http_->start();
+    for (auto& shard : shards_) {
+        if (shard->core->sweep)
+            boost::asio::post(*shard->io, [core = shard->core] {
+                if (!core->detached.load(std::memory_order_relaxed)) ShardCore::start_sweep(core);
+            });
+        if (!shard->acceptor) continue;
+        // Several accepts outstanding per listener: on io_uring each one is an
+        // SQE already in the ring, which is as close to multishot accept as Asio
+        // gets. A shared io_context may run them on several threads, so keep one.
+        const std::size_t accepts = owns_shards_ ? std::max<std::size_t>(1, cfg_.accepts_in_flight) : 1;
+        for (std::size_t i = 0; i < accepts; ++i)
+            boost::asio::post(shard->acceptor->get_executor(), [this, s = shard.get(), core = shard->core] {
+                if (!core->detached.load(std::memory_order_relaxed)) do_accept(*s);
+            });
+    }
+    if (!owns_shards_ || !threads_.empty()) return;
+    for (std::size_t i = 0; i < shards_.size(); ++i) {
+        auto* io = shards_[i]->io;
+        threads_.emplace_back([io] { io->run(); });
+        if (cfg_.pin_threads) pin_to_cpu(threads_.back(), i);
+    }
 }
 
-void AsyncServer::do_accept() {
-    acceptor_.async_accept(
-        [this](const boost::system::error_code& ec, tcp::socket socket) {
-            if (!ec) std::make_shared<Session>(std::move(socket), cfg_)->start();
-            do_accept();
+void AsyncServer::stop() {
+    if (metrics_http_) metrics_http_->stop();
+    if (owns_shards_) {
+        // A closure posted now might never run once the io_context stops;
+        // join() closes the listeners after the threads have exited
+        for (auto& shard : shards_) {
+            shard->work.reset();
+            shard->io->stop();
+        }
+        return;
+    }
+    for (auto& shard : shards_) {
+        if (shard->core->sweep)
+            boost::asio::post(*shard->io, [core = shard->core] {
+                if (!core->detached.load(std::memory_order_relaxed)) core->sweep->cancel();
+            });
+        if (!shard->acceptor) continue;
+        boost::asio::post(shard->acceptor->get_executor(), [s = shard.get(), core = shard->core] {
+            if (core->detached.load(std::memory_order_relaxed)) return; // closed with the shard
+            boost::system::error_code ig;
+            s->acceptor->close(ig);
+            s->accept_backoff->cancel();
         });
+    }
+}
+
+void AsyncServer::join() {
+    for (auto& t : threads_)
+        if (t.joinable()) t.join();
+    threads_.clear();
+    if (!owns_shards_) return;
+    // No thread runs a stopped shard any more, so its listener is ours to close
+    for (auto& shard : shards_) {
+        if (!shard->acceptor || !shard->io->stopped()) continue;
+        boost::system::error_code ig;
+        shard->acceptor->close(ig);
+        shard->accept_backoff->cancel();
+    }
+}
+
+// Owned shards each get one posted closure that queues the frame on all of
+// their sessions; a shared io_context has no single thread to hand off to,
+// so each session's inbox is used instead. Sessions are collected first: the
+// last reference may be ours, and ~Session takes the list lock.
+void AsyncServer::broadcast(const SharedFrame& frame, uint64_t conflation_key) {
+    if (!whole_frame(frame.size()))
+        throw boost::system::system_error(make_error_code(boost::asio::error::invalid_argument));
+    for (auto& shard : shards_) {
+        if (!owns_shards_) {
+            std::vector<std::shared_ptr<Session>> targets;
+            shard->sessions.for_each([&](SessionList::Hook& hook) {
+                if (auto session = Session::from_hook(hook).weak_from_this().lock())
+                    targets.push_back(std::move(session));
+            });
+            for (auto& session : targets)
+                if (!session->closed()) session->send_from_any_thread(FrameBuffer(frame), conflation_key);
+            continue;
+        }
+        boost::asio::post(*shard->io, [s = shard.get(), frame, conflation_key] {
+            s->sessions.for_each([&](SessionList::Hook& hook) {
+                auto& session = Session::from_hook(hook);
+                if (!session.closed()) session.enqueue_write(FrameBuffer(frame), conflation_key);
+            });
+        });
+    }
+}
+
+void AsyncServer::publish(std::string_view topic, const void* data, std::size_t size) {
+    if (topic.size() > proto::MAX_TOPIC_LEN)
+        throw boost::system::system_error(make_error_code(boost::asio::error::message_size));
+    auto message = SharedFrame::frame(proto::MSG_MESSAGE, 2 + topic.size() + size);
+    proto::write_u16be(message.payload(), static_cast<uint16_t>(topic.size()));
+    std::memcpy(message.payload() + 2, topic.data(), topic.size());
+    if (size) std::memcpy(message.payload() + 2 + topic.size(), data, size);
+    fan_out(message);
+}
+
+namespace {
+
+std::string_view topic_of(const SharedFrame& message) noexcept {
+    return std::string_view(message.payload() + 2, proto::read_u16be(message.payload()));
+}
+
+// Conflation key for a topic's MESSAGEs; never 0, which means untagged
+uint64_t topic_key(std::string_view topic) noexcept {
+    const uint64_t h = std::hash<std::string_view>{}(topic);
+    return h ? h : 1;
+}
+
+} // namespace
+
+// Same handoff as broadcast(), limited to shards with subscriptions. The
+// publisher's own shard is served inline, so a subscriber next to it sees
+// the MESSAGE without a post. Per publisher, each subscriber receives
+// messages in publish order, except that with fragment_size set a
+// fragmented MESSAGE may be overtaken by smaller ones published after it.
+void AsyncServer::fan_out(const SharedFrame& message) {
+    const uint64_t key = cfg_.conflate_writes ? topic_key(topic_of(message)) : 0;
+    for (auto& shard : shards_) {
+        if (shard->topics.empty()) continue;
+        if (!owns_shards_) {
+            std::vector<std::shared_ptr<Session>> targets;
+            shard->topics.for_each(topic_of(message), [&](Session& session) {
+                if (auto s = session.weak_from_this().lock()) targets.push_back(std::move(s));
+            });
+            for (auto& session : targets) {
+                auto ex = session->get_executor();
+                boost::asio::post(ex, [session = std::move(session), message, key] { session->deliver(message, key); });
+            }
+            continue;
+        }
+        auto deliver_all = [s = shard.get(), message, key] {
+            s->topics.for_each(topic_of(message), [&](Session& session) { session.deliver(message, key); });
+        };
+        if (shard->io->get_executor().running_in_this_thread()) deliver_all();
+        else boost::asio::post(*shard->io, std::move(deliver_all));
+    }
+}
+
+AsyncServer::Shard& AsyncServer::next_shard() {
+    auto& shard = *shards_[next_shard_];
+    next_shard_ = (next_shard_ + 1) % shards_.size();
+    return shard;
+}
+
+// Accept completions co-own the listener's core: one queued when a
+// shared-reactor server was destroyed finds it detached and touches nothing
+void AsyncServer::do_accept(Shard& listener) {
+    // Only the shared single listener hands sockets to other shards
+    auto& target = (cfg_.reuse_port && owns_shards_) ? listener : next_shard();
+    listener.acceptor->async_accept(target.session_executor(),
+        [this, &listener, &target, core = listener.core](const boost::system::error_code& ec, tcp::socket socket) {
+            if (core->detached.load(std::memory_order_relaxed)) return;
+            if (ec == boost::asio::error::operation_aborted || !listener.acceptor->is_open()) return;
+            if (out_of_resources(ec)) return back_off_accept(listener);
+            if (!ec) admit(target, std::move(socket));
+            do_accept(listener);
+        });
+}
+
+// Out of descriptors or memory: accepting again at once would fail the same
+// way in a hot loop, so every accept of this listener waits one backoff
+// period, leaving new connections in the kernel's backlog meanwhile
+void AsyncServer::back_off_accept(Shard& listener) {
+    if (cfg_.metrics) ServerCounters::add(local_server_counters().accept_backoffs);
+    if (listener.parked_accepts++ > 0) return;
+    listener.accept_backoff->expires_after(cfg_.accept_backoff);
+    listener.accept_backoff->async_wait([this, &listener, core = listener.core](const boost::system::error_code& ec) {
+        if (ec || core->detached.load(std::memory_order_relaxed)) return;
+        const std::size_t parked = std::exchange(listener.parked_accepts, 0);
+        if (!listener.acceptor->is_open()) return;
+        for (std::size_t i = 0; i < parked; ++i) do_accept(listener);
+    });
+}
+
+// Connections over a limit are closed on the accepting thread, before a
+// session or any buffer exists for them
+void AsyncServer::admit(Shard& target, tcp::socket socket) {
+    boost::system::error_code ec;
+    const auto peer = socket.remote_endpoint(ec);
+    if (ec) return; // already gone
+    Admission::Slot slot;
+    const auto verdict = admission_->admit(peer.address(), slot);
+    if (verdict != Admission::Verdict::admitted) {
+        if (cfg_.metrics) {
+            const auto reason = verdict == Admission::Verdict::over_limit ? RejectReason::max_connections
+                                                                          : RejectReason::max_connections_per_ip;
+            ServerCounters::add(local_server_counters().rejects[static_cast<std::size_t>(reason)]);
+        }
+        socket.close(ec);
+        return;
+    }
+    // Build the session on its own shard so it never touches another thread
+    auto ex = socket.get_executor();
+    boost::asio::dispatch(ex, [this, core = target.core, s = std::move(socket), slot = std::move(slot)]() mutable {
+        if (core->detached.load(std::memory_order_relaxed)) return; // queued past the server's lifetime
+        std::make_shared<Session>(std::move(s), std::move(core), router_, std::move(slot))->start();
+    });
 }
 
 } // namespace swiftwire
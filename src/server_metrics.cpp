@@ -0,0 +1,153 @@
+#include "swiftwire/server_metrics.hpp"
+#include <boost/asio/error.hpp>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace swiftwire {
+namespace {
+
+struct Registry {
+    std::mutex mu;
+    std::vector<std::unique_ptr<ServerCounters>> sets;
+};
+
+Registry& registry() {
+    static Registry* r = new Registry; // intentionally leaked: threads may record during static destruction
+    return *r;
+}
+
+void merge_into(ServerCounters::counter& dst, const ServerCounters::counter& src) noexcept {
+    if (uint64_t n = src.load(std::memory_order_relaxed)) ServerCounters::add(dst, n);
+}
+
+void metric_header(std::string& out, const char* name, const char* type, const char* help) {
+    out += "# HELP "; out += name; out += ' '; out += help; out += '\n';
+    out += "# TYPE "; out += name; out += ' '; out += type; out += '\n';
+}
+
+void metric(std::string& out, const char* name, const char* type, const char* help, uint64_t v) {
+    metric_header(out, name, type, help);
+    out += name; out += ' '; out += std::to_string(v); out += '\n';
+}
+
+void per_type(std::string& out, const char* name, const char* help,
+              const std::array<ServerCounters::counter, 256>& counts) {
+    metric_header(out, name, "counter", help);
+    char label[32];
+    for (std::size_t t = 0; t < counts.size(); ++t) {
+        const uint64_t v = counts[t].load(std::memory_order_relaxed);
+        if (v == 0) continue;
+        std::snprintf(label, sizeof(label), "{type=\"0x%02zx\"} ", t);
+        out += name; out += label; out += std::to_string(v); out += '\n';
+    }
+}
+
+} // namespace
+
+CloseReason classify_close(const boost::system::error_code& ec) noexcept {
+    namespace error = boost::asio::error;
+    if (ec == error::eof || ec == error::connection_reset || ec == error::broken_pipe)
+        return CloseReason::peer_closed;
+    if (ec == error::timed_out) return CloseReason::idle_timeout;
+    if (ec == error::message_size) return CloseReason::frame_too_large;
+    if (ec == error::no_buffer_space) return CloseReason::write_overflow;
+    if (ec == error::shut_down || ec == error::operation_aborted) return CloseReason::local_close;
+    return CloseReason::other;
+}
+
+const char* close_reason_name(CloseReason r) noexcept {
+    switch (r) {
+    case CloseReason::peer_closed: return "peer_closed";
+    case CloseReason::idle_timeout: return "idle_timeout";
+    case CloseReason::frame_too_large: return "frame_too_large";
+    case CloseReason::write_overflow: return "write_overflow";
+    case CloseReason::local_close: return "local_close";
+    case CloseReason::other: break;
+    }
+    return "other";
+}
+
+const char* reject_reason_name(RejectReason r) noexcept {
+    switch (r) {
+    case RejectReason::max_connections: return "max_connections";
+    case RejectReason::max_connections_per_ip: break;
+    }
+    return "max_connections_per_ip";
+}
+
+void ServerCounters::merge(const ServerCounters& other) noexcept {
+    merge_into(sessions_accepted, other.sessions_accepted);
+    merge_into(sessions_closed, other.sessions_closed);
+    merge_into(bytes_in, other.bytes_in);
+    merge_into(bytes_out, other.bytes_out);
+    merge_into(write_queue_bytes, other.write_queue_bytes);
+    merge_into(backpressure_pauses, other.backpressure_pauses);
+    merge_into(pubsub_dropped, other.pubsub_dropped);
+    merge_into(frames_conflated, other.frames_conflated);
+    merge_into(accept_backoffs, other.accept_backoffs);
+    for (std::size_t i = 0; i < frames_in.size(); ++i) merge_into(frames_in[i], other.frames_in[i]);
+    for (std::size_t i = 0; i < frames_out.size(); ++i) merge_into(frames_out[i], other.frames_out[i]);
+    for (std::size_t i = 0; i < closes.size(); ++i) merge_into(closes[i], other.closes[i]);
+    for (std::size_t i = 0; i < rejects.size(); ++i) merge_into(rejects[i], other.rejects[i]);
+}
+
+ServerCounters& local_server_counters() {
+    thread_local ServerCounters* mine = [] {
+        auto& r = registry();
+        std::lock_guard<std::mutex> lk(r.mu);
+        r.sets.push_back(std::make_unique<ServerCounters>());
+        return r.sets.back().get();
+    }();
+    return *mine;
+}
+
+void collect_server_counters(ServerCounters& out) {
+    auto& r = registry();
+    std::lock_guard<std::mutex> lk(r.mu);
+    for (auto& set : r.sets) out.merge(*set);
+}
+
+std::string render_prometheus(const ServerCounters& c) {
+    auto get = [](const ServerCounters::counter& v) { return v.load(std::memory_order_relaxed); };
+    std::string out;
+    out.reserve(4096);
+    metric(out, "swiftwire_sessions_accepted_total", "counter", "Sessions accepted.", get(c.sessions_accepted));
+    metric(out, "swiftwire_sessions_active", "gauge", "Sessions currently open.",
+           get(c.sessions_accepted) - get(c.sessions_closed));
+    metric(out, "swiftwire_bytes_in_total", "counter", "Bytes read from peers.", get(c.bytes_in));
+    metric(out, "swiftwire_bytes_out_total", "counter", "Bytes written to peers.", get(c.bytes_out));
+    metric(out, "swiftwire_write_queue_bytes", "gauge", "Bytes queued for writing across all sessions.",
+           get(c.write_queue_bytes));
+    metric(out, "swiftwire_backpressure_pauses_total", "counter",
+           "Times a session stopped reading at the write high watermark.", get(c.backpressure_pauses));
+    metric(out, "swiftwire_pubsub_dropped_total", "counter",
+           "Pub/sub messages skipped for subscribers above the write high watermark.", get(c.pubsub_dropped));
+    metric(out, "swiftwire_frames_conflated_total", "counter",
+           "Queued frames replaced by a newer frame with the same conflation key.", get(c.frames_conflated));
+    per_type(out, "swiftwire_frames_in_total", "Frames received, by message type.", c.frames_in);
+    per_type(out, "swiftwire_frames_out_total", "Frames queued for sending, by message type.", c.frames_out);
+    metric_header(out, "swiftwire_session_closes_total", "counter", "Sessions closed, by reason.");
+    for (std::size_t i = 0; i < close_reason_count; ++i) {
+        out += "swiftwire_session_closes_total{reason=\"";
+        out += close_reason_name(static_cast<CloseReason>(i));
+        out += "\"} ";
+        out += std::to_string(get(c.closes[i]));
+        out += '\n';
+    }
+    metric_header(out, "swiftwire_connections_rejected_total", "counter",
+                  "Connections closed right after accept, by limit.");
+    for (std::size_t i = 0; i < reject_reason_count; ++i) {
+        out += "swiftwire_connections_rejected_total{reason=\"";
+        out += reject_reason_name(static_cast<RejectReason>(i));
+        out += "\"} ";
+        out += std::to_string(get(c.rejects[i]));
+        out += '\n';
+    }
+    metric(out, "swiftwire_accept_backoffs_total", "counter",
+           "Times accepting paused after running out of descriptors or memory.", get(c.accept_backoffs));
+    return out;
+}
+
+} // namespace swiftwire
@@ -0,0 +1,46 @@
+#include "swiftwire/stage_metrics.hpp"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace swiftwire {
+namespace {
+
+// Every thread's set, registered once on first use and never freed
+struct Registry {
+    std::mutex mu;
+    std::vector<std::unique_ptr<StageHistograms>> sets;
+};
+
+Registry& registry() {
+    static Registry* r = new Registry; // intentionally leaked: threads may record during static destruction
+    return *r;
+}
+
+} // namespace
+
+StageHistograms& local_stage_metrics() {
+    thread_local StageHistograms* mine = [] {
+        auto& r = registry();
+        std::lock_guard<std::mutex> lk(r.mu);
+        r.sets.push_back(std::make_unique<StageHistograms>());
+        return r.sets.back().get();
+    }();
+    return *mine;
+}
+
+void collect_stage_metrics(StageHistograms& out) {
+    auto& r = registry();
+    std::lock_guard<std::mutex> lk(r.mu);
+    for (auto& set : r.sets)
+        for (std::size_t i = 0; i < stage_count; ++i) out.stages[i].merge(set->stages[i]);
+}
+
+void reset_stage_metrics() {
+    auto& r = registry();
+    std::lock_guard<std::mutex> lk(r.mu);
+    for (auto& set : r.sets)
+        for (auto& h : set->stages) h.reset();
+}
+
+} // namespace swiftwire
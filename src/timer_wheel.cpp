@@ -0,0 +1,76 @@
+#include "timer_wheel.hpp"
+#include <algorithm>
+
+namespace swiftwire {
+
+TimerWheel::TimerWheel(std::chrono::milliseconds tick, std::chrono::milliseconds timeout, ExpireFn on_expire)
+    : tick_(std::max(tick, std::chrono::milliseconds(1))),
+      timeout_ticks_(static_cast<uint32_t>(std::max<std::int64_t>(1, (timeout.count() + tick_.count() - 1) / tick_.count()))),
+      on_expire_(on_expire) {}
+
+void TimerWheel::add(Entry& e) {
+    std::lock_guard<std::mutex> lk(mu_);
+    const uint32_t now = now_.load(std::memory_order_relaxed);
+    e.last_tick.store(now, std::memory_order_relaxed);
+    insert(e, now + timeout_ticks_);
+}
+
+void TimerWheel::remove(Entry& e) {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (e.pprev) unlink(e);
+}
+
+void TimerWheel::advance() {
+    std::lock_guard<std::mutex> lk(mu_);
+    const uint32_t now = now_.load(std::memory_order_relaxed) + 1;
+    now_.store(now, std::memory_order_relaxed);
+
+    // Entering a new level-0 revolution: spread the matching level-1 slot out
+    if ((now & (kL0Slots - 1)) == 0) {
+        Entry* e = l1_[(now >> kL0Bits) % kL1Slots].head;
+        l1_[(now >> kL0Bits) % kL1Slots].head = nullptr;
+        while (e) {
+            Entry* next = e->next;
+            e->pprev = nullptr;
+            insert(*e, e->last_tick.load(std::memory_order_relaxed) + timeout_ticks_);
+            e = next;
+        }
+    }
+
+    Entry* e = l0_[now & (kL0Slots - 1)].head;
+    l0_[now & (kL0Slots - 1)].head = nullptr;
+    while (e) {
+        Entry* next = e->next;
+        e->pprev = nullptr;
+        const uint32_t deadline = e->last_tick.load(std::memory_order_relaxed) + timeout_ticks_;
+        if (static_cast<int32_t>(deadline - now) <= 0) on_expire_(e);
+        else insert(*e, deadline);
+        e = next;
+    }
+}
+
+void TimerWheel::insert(Entry& e, uint32_t deadline) {
+    const uint32_t now = now_.load(std::memory_order_relaxed);
+    const int32_t delta = static_cast<int32_t>(deadline - now);
+    if (delta <= 0) return link(l0_[(now + 1) & (kL0Slots - 1)], e);
+    if (delta < static_cast<int32_t>(kL0Slots)) return link(l0_[deadline & (kL0Slots - 1)], e);
+    // Beyond the level-1 horizon: park in the slot cascaded last; it is re-filed from last_tick then
+    if (delta >= static_cast<int32_t>(kL0Slots * kL1Slots)) deadline = now + (kL0Slots * (kL1Slots - 1));
+    link(l1_[(deadline >> kL0Bits) % kL1Slots], e);
+}
+
+void TimerWheel::link(Slot& slot, Entry& e) {
+    e.next = slot.head;
+    if (slot.head) slot.head->pprev = &e.next;
+    e.pprev = &slot.head;
+    slot.head = &e;
+}
+
+void TimerWheel::unlink(Entry& e) {
+    *e.pprev = e.next;
+    if (e.next) e.next->pprev = e.pprev;
+    e.next = nullptr;
+    e.pprev = nullptr;
+}
+
+} // namespace swiftwire
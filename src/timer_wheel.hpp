@@ -0,0 +1,60 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace swiftwire {
+
+// Two-level hashed timer wheel for idle timeouts. Entries only stamp their
+// last-activity tick on the hot path; advance() visits the due slot once per
+// tick, re-files entries that saw activity and expires the rest. Structural
+// changes (add/remove/advance) take a mutex, which is uncontended when the
+// wheel belongs to a single-threaded shard.
+class TimerWheel {
+public:
+    struct Entry {
+        Entry* next = nullptr;
+        Entry** pprev = nullptr;   // null while not filed in a slot
+        std::atomic<uint32_t> last_tick{0};
+    };
+    using ExpireFn = void (*)(Entry*);
+
+    TimerWheel(std::chrono::milliseconds tick, std::chrono::milliseconds timeout, ExpireFn on_expire);
+
+    std::chrono::milliseconds tick() const noexcept { return tick_; }
+
+    // Hot path: one relaxed load and one relaxed store
+    void touch(Entry& e) const noexcept {
+        e.last_tick.store(now_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    void add(Entry& e);
+    void remove(Entry& e);
+
+    // Move one tick forward; on_expire runs for idle entries (already unlinked)
+    // under the wheel lock, so it must not call back into the wheel
+    void advance();
+
+private:
+    static constexpr uint32_t kL0Bits = 8;
+    static constexpr uint32_t kL0Slots = 1u << kL0Bits;  // ticks
+    static constexpr uint32_t kL1Slots = 64;             // x kL0Slots ticks
+
+    struct Slot { Entry* head = nullptr; };
+
+    void insert(Entry& e, uint32_t deadline);
+    static void link(Slot& slot, Entry& e);
+    static void unlink(Entry& e);
+
+    std::chrono::milliseconds tick_;
+    uint32_t timeout_ticks_;
+    ExpireFn on_expire_;
+    std::atomic<uint32_t> now_{0};
+    std::mutex mu_;
+    std::array<Slot, kL0Slots> l0_{};
+    std::array<Slot, kL1Slots> l1_{};
+};
+
+} // namespace swiftwire
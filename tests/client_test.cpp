@@ -0,0 +1,196 @@
+// AsyncClient: replies are matched to requests by correlation id whatever
+// order they arrive in, a request past its deadline completes once with
+// timed_out, and frames above the client's max_frame close the connection.
+#include "swiftwire/client.hpp"
+#include "swiftwire/protocol.hpp"
+#include "swiftwire/server.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std::chrono_literals;
+namespace proto = swiftwire::proto;
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            std::exit(1);                                                       \
+        }                                                                       \
+    } while (0)
+
+namespace {
+
+constexpr uint8_t kHold = 0x20;     // held until kRelease, then answered newest first
+constexpr uint8_t kRelease = 0x21;
+constexpr uint8_t kIgnore = 0x22;   // never answered
+constexpr uint8_t kBig = 0x23;      // answered with a 2 MiB payload
+
+struct Held {
+    swiftwire::SessionHandle handle;
+    uint32_t corr_id;
+    std::string payload;
+};
+
+// A RESPONSE for `corr_id`, sent later through a SessionHandle
+swiftwire::FrameBuffer response(uint32_t corr_id, uint8_t type, const std::string& payload) {
+    auto buf = swiftwire::FrameBuffer::frame(proto::MSG_RESPONSE, 4 + 1 + payload.size());
+    proto::write_u32be(buf.payload(), corr_id);
+    buf.payload()[4] = static_cast<char>(type);
+    std::memcpy(buf.payload() + 5, payload.data(), payload.size());
+    return buf;
+}
+
+class Fixture {
+public:
+    Fixture() : server_({boost::asio::ip::make_address("127.0.0.1"), 0}, config()) {
+        auto& router = server_.router();
+        router.on(kHold, [this](swiftwire::MessageContext& ctx, const swiftwire::Message& m) {
+            std::lock_guard<std::mutex> lk(mu_);
+            held_.push_back(Held{ctx.handle(), ctx.correlation_id(), std::string(m.data, m.size)});
+        });
+        router.on(kRelease, [this](swiftwire::MessageContext& ctx, const swiftwire::Message&) {
+            std::lock_guard<std::mutex> lk(mu_);
+            for (auto it = held_.rbegin(); it != held_.rend(); ++it)
+                it->handle.send(response(it->corr_id, kHold, it->payload));
+            held_.clear();
+            ctx.reply(kRelease, nullptr, 0);
+        });
+        router.on(kIgnore, [](swiftwire::MessageContext&, const swiftwire::Message&) {});
+        router.on(kBig, [](swiftwire::MessageContext& ctx, const swiftwire::Message&) {
+            const std::string big(2u << 20, 'b');
+            ctx.reply(kBig, big.data(), big.size());
+        });
+        server_.run();
+    }
+    ~Fixture() {
+        server_.stop();
+        server_.join();
+    }
+
+    std::shared_ptr<swiftwire::AsyncClient> connect(boost::asio::io_context& io) {
+        auto client = std::make_shared<swiftwire::AsyncClient>(io);
+        bool done = false, ok = false;
+        client->async_connect("127.0.0.1", std::to_string(server_.local_endpoint().port()), 2s, [&](auto ec) {
+            ok = !ec;
+            done = true;
+        });
+        run_until(io, [&] { return done; });
+        CHECK(ok);
+        return client;
+    }
+
+    // An idle client lets the io_context run out of work and stop, so restart it
+    template <typename F>
+    static void run_until(boost::asio::io_context& io, F&& done) {
+        const auto deadline = std::chrono::steady_clock::now() + 10s;
+        while (!done() && std::chrono::steady_clock::now() < deadline) {
+            if (io.stopped()) io.restart();
+            io.run_for(5ms);
+        }
+        CHECK(done());
+    }
+
+private:
+    static swiftwire::ServerConfig config() {
+        swiftwire::ServerConfig cfg;
+        cfg.threads = 1;
+        return cfg;
+    }
+
+    swiftwire::AsyncServer server_;
+    std::mutex mu_;
+    std::vector<Held> held_;
+};
+
+// Replies arrive in reverse order; each lands with the request it answers
+void multiplexed_out_of_order(Fixture& fx) {
+    boost::asio::io_context io;
+    auto client = fx.connect(io);
+    constexpr int n = 50;
+    int matched = 0, completed = 0;
+    for (int i = 0; i < n; ++i) {
+        const std::string payload = "req-" + std::to_string(i);
+        client->async_request(kHold, payload, 5s, [&, payload](auto ec, uint8_t type, swiftwire::Payload p) {
+            ++completed;
+            if (!ec && type == kHold && p.view() == payload) ++matched;
+        });
+    }
+    CHECK(client->outstanding() == n);
+    bool released = false;
+    client->async_request(kRelease, "", 5s, [&](auto ec, uint8_t, swiftwire::Payload) { released = !ec; });
+    Fixture::run_until(io, [&] { return completed == n && released; });
+    CHECK(matched == n);
+    CHECK(client->outstanding() == 0);
+}
+
+// A request past its deadline completes with timed_out, once, and the
+// connection keeps serving others; its late reply is dropped
+void deadline_expiry(Fixture& fx) {
+    boost::asio::io_context io;
+    auto client = fx.connect(io);
+    int ignored_calls = 0, held_calls = 0;
+    boost::system::error_code ignored_ec, held_ec;
+    const auto t0 = std::chrono::steady_clock::now();
+    client->async_request(kIgnore, "x", 50ms, [&](auto ec, uint8_t, swiftwire::Payload) {
+        ignored_ec = ec;
+        ++ignored_calls;
+    });
+    client->async_request(kHold, "late", 100ms, [&](auto ec, uint8_t, swiftwire::Payload) {
+        held_ec = ec;
+        ++held_calls;
+    });
+    Fixture::run_until(io, [&] { return ignored_calls && held_calls; });
+    CHECK(std::chrono::steady_clock::now() - t0 >= 50ms);
+    CHECK(ignored_ec == boost::asio::error::timed_out);
+    CHECK(held_ec == boost::asio::error::timed_out);
+    CHECK(client->outstanding() == 0);
+
+    bool released = false;
+    client->async_request(kRelease, "", 5s, [&](auto ec, uint8_t, swiftwire::Payload) { released = !ec; });
+    Fixture::run_until(io, [&] { return released; });
+    io.restart();
+    io.run_for(20ms);
+    CHECK(ignored_calls == 1 && held_calls == 1);
+}
+
+// A 2 MiB reply kills the connection at the default max_frame and arrives
+// once the client accepts frames that large
+void max_frame_setting(Fixture& fx) {
+    boost::asio::io_context io;
+    auto small = fx.connect(io);
+    boost::system::error_code ec_small;
+    bool done = false;
+    small->async_request(kBig, "", 5s, [&](auto ec, uint8_t, swiftwire::Payload) {
+        ec_small = ec;
+        done = true;
+    });
+    Fixture::run_until(io, [&] { return done; });
+    CHECK(ec_small == boost::asio::error::message_size);
+
+    auto large = fx.connect(io);
+    large->set_max_frame(4u << 20);
+    std::size_t got = 0;
+    done = false;
+    large->async_request(kBig, "", 5s, [&](auto ec, uint8_t, swiftwire::Payload p) {
+        if (!ec) got = p.size();
+        done = true;
+    });
+    Fixture::run_until(io, [&] { return done; });
+    CHECK(got == (2u << 20));
+}
+
+} // namespace
+
+int main() {
+    Fixture fx;
+    multiplexed_out_of_order(fx);
+    deadline_expiry(fx);
+    max_frame_setting(fx);
+    std::puts("client_test ok");
+    return 0;
+}
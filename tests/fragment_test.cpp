@@ -0,0 +1,141 @@
+// Reassembler: announced totals must not pin memory, and a connection holds at
+// most max_message bytes across all of its incomplete streams. End to end, a
+// fragmented message round-trips intact, within the server's max_message.
+#include "swiftwire/client.hpp"
+#include "swiftwire/fragment.hpp"
+#include "swiftwire/server.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using swiftwire::Reassembler;
+namespace proto = swiftwire::proto;
+using namespace std::chrono_literals;
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            std::exit(1);                                                       \
+        }                                                                       \
+    } while (0)
+
+namespace {
+
+constexpr std::size_t kMaxMessage = 16u << 20;
+
+// FRAGMENT payload: [stream][total][chunk]
+std::string fragment(uint32_t stream, uint32_t total, const std::string& chunk = {}) {
+    std::string p(proto::FRAGMENT_HEADER_LEN, '\0');
+    proto::write_u32be(p.data(), stream);
+    proto::write_u32be(p.data() + 4, total);
+    return p + chunk;
+}
+
+bool add(Reassembler& r, const std::string& payload, std::vector<std::string>* done = nullptr) {
+    return r.add(payload.data(), payload.size(), kMaxMessage,
+                 [&](const char* body, std::size_t n) { if (done) done->emplace_back(body, n); });
+}
+
+// Every stream slot opened with only a header announcing max_message
+void header_only_streams() {
+    Reassembler r;
+    for (uint32_t id = 0; id < Reassembler::max_streams; ++id) CHECK(add(r, fragment(id, kMaxMessage)));
+    CHECK(r.buffered() == 0);
+    CHECK(!add(r, fragment(Reassembler::max_streams, kMaxMessage)));  // out of stream slots
+}
+
+// Chunks of different streams together stay under one max_message
+void held_bytes_capped() {
+    Reassembler r;
+    const std::string chunk(1u << 20, 'x');
+    std::size_t held = 0;
+    uint32_t id = 0;
+    for (; held + chunk.size() <= kMaxMessage; held += chunk.size(), ++id)
+        CHECK(add(r, fragment(id % Reassembler::max_streams, kMaxMessage, chunk)));
+    CHECK(r.buffered() == held);
+    CHECK(!add(r, fragment(id % Reassembler::max_streams, kMaxMessage, chunk)));
+}
+
+// Interleaved streams still complete in order, and give their bytes back
+void reassembles() {
+    Reassembler r;
+    std::vector<std::string> done;
+    CHECK(add(r, fragment(1, 6, "abc"), &done));
+    CHECK(add(r, fragment(2, 4, "wx"), &done));
+    CHECK(add(r, fragment(1, 6, "def"), &done));
+    CHECK(done.size() == 1 && done[0] == "abcdef");
+    CHECK(r.buffered() == 2);
+    CHECK(add(r, fragment(2, 4, "yz"), &done));
+    CHECK(done.size() == 2 && done[1] == "wxyz");
+    CHECK(r.buffered() == 0);
+    CHECK(!add(r, fragment(3, 2, "abc")));  // past its announced total
+}
+
+// Echoes `body` through a server with 64 KiB fragments both ways; false when
+// the request fails
+bool echo(swiftwire::ServerConfig cfg, const std::string& body, std::string& reply) {
+    cfg.threads = 1;
+    cfg.fragment_size = 64u << 10;
+    cfg.max_write_queue_bytes = 64u << 20;
+    cfg.write_high_watermark = 32u << 20;
+    swiftwire::AsyncServer server({boost::asio::ip::make_address("127.0.0.1"), 0}, cfg);
+    server.router().on(0x10, [](swiftwire::MessageContext& ctx, const swiftwire::Message& m) {
+        ctx.reply(0x90, m.data, m.size);
+    });
+    server.run();
+
+    boost::asio::io_context io;
+    auto client = std::make_shared<swiftwire::AsyncClient>(io);
+    client->set_fragment_size(64u << 10);
+    bool done = false, ok = false;
+    client->async_connect("127.0.0.1", std::to_string(server.local_endpoint().port()), 2s, [&](auto ec) {
+        if (ec) {
+            done = true;
+            return;
+        }
+        client->async_request(0x10, body, 10s, [&](auto ec, uint8_t type, swiftwire::Payload p) {
+            ok = !ec && type == 0x90;
+            if (ok) reply.assign(p.data(), p.size());
+            done = true;
+        });
+    });
+    const auto deadline = std::chrono::steady_clock::now() + 15s;
+    while (!done && std::chrono::steady_clock::now() < deadline) io.run_for(10ms);
+    client->close();
+    server.stop();
+    server.join();
+    return ok;
+}
+
+void echo_8mib() {
+    std::string body(8u << 20, '\0');
+    for (std::size_t i = 0; i < body.size(); ++i) body[i] = static_cast<char>(i * 7 + (i >> 13));
+    swiftwire::ServerConfig cfg;
+    cfg.max_message = 16u << 20;
+    std::string reply;
+    CHECK(echo(cfg, body, reply));
+    CHECK(reply == body);
+}
+
+// max_message defaults to max_frame: fragments may not buffer more than a frame
+void default_limit_is_max_frame() {
+    swiftwire::ServerConfig cfg;
+    std::string reply;
+    CHECK(echo(cfg, std::string(cfg.max_frame / 2, 'x'), reply));
+    CHECK(!echo(cfg, std::string(cfg.max_frame + 1, 'x'), reply));
+}
+
+} // namespace
+
+int main() {
+    header_only_streams();
+    held_bytes_capped();
+    reassembles();
+    echo_8mib();
+    default_limit_is_max_frame();
+    std::puts("fragment_test ok");
+    return 0;
+}
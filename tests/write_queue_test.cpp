@@ -0,0 +1,291 @@
+// WriteQueue: frames handed out by gather() must stay put while more frames
+// are queued before the writev completes, keyed pushes conflate only frames
+// that are not yet on the wire, and lanes take turns only at frame boundaries.
+#include "swiftwire/write_queue.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using swiftwire::FrameBuffer;
+using swiftwire::WriteQueue;
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            std::exit(1);                                                       \
+        }                                                                       \
+    } while (0)
+
+namespace {
+
+FrameBuffer frame(uint8_t type, const std::string& payload) {
+    auto buf = FrameBuffer::frame(type, payload.size());
+    std::memcpy(buf.payload(), payload.data(), payload.size());
+    return buf;
+}
+
+// Pushes past every lane's initial capacity between gather() and consume()
+void push_while_in_flight() {
+    WriteQueue q;
+    std::vector<boost::asio::const_buffer> iov;
+    for (int i = 0; i < 3; ++i) q.push(frame(0x10, "in-flight-" + std::to_string(i)));  // inline frames
+    auto batch = q.gather(iov, WriteQueue::max_iov, 1 << 20);
+    std::vector<boost::asio::const_buffer> sent(batch.begin(), batch.end());
+    std::vector<std::string> expected;
+    for (auto& b : sent) expected.emplace_back(static_cast<const char*>(b.data()), b.size());
+    CHECK(sent.size() == 3);
+
+    for (int i = 0; i < 1000; ++i) {
+        q.push(frame(0x10, "bulk-" + std::to_string(i)));
+        q.push(frame(0x11, "ctl-" + std::to_string(i)), 0, 0, WriteQueue::control);
+        q.push(frame(0x12, std::string(200, char('a' + i % 26))), 0, 0, WriteQueue::fragment);
+    }
+
+    // The writev still reads the buffers it was given, at the same addresses
+    for (std::size_t i = 0; i < sent.size(); ++i)
+        CHECK(std::memcmp(sent[i].data(), expected[i].data(), expected[i].size()) == 0);
+
+    // Write the in-flight batch and one more byte: the three frames retire
+    std::size_t n = 1;
+    for (auto& b : sent) n += b.size();
+    std::size_t retired = 0;
+    q.consume(n - 1, [&](uint64_t) { ++retired; });
+    CHECK(retired == 3);
+    CHECK(q.size() == 3000);
+}
+
+// A gather repeated before anything was written hands out the same addresses
+void addresses_stable_across_growth() {
+    WriteQueue q;
+    std::vector<boost::asio::const_buffer> iov;
+    q.push(frame(0x10, "head"));
+    const auto first = *q.gather(iov, WriteQueue::max_iov, 1 << 20).begin();
+    for (int i = 0; i < 1000; ++i) q.push(frame(0x10, std::to_string(i)));
+    q.consume(0);
+    const auto again = *q.gather(iov, WriteQueue::max_iov, 1 << 20).begin();
+    CHECK(again.data() == first.data());
+    CHECK(again.size() == first.size());
+}
+
+// Drain everything through short writes and check every byte arrives in lane order
+void drain_in_order() {
+    WriteQueue q;
+    std::vector<boost::asio::const_buffer> iov;
+    std::string want_bulk, got;
+    for (int i = 0; i < 500; ++i) {
+        auto f = frame(0x10, "frame-" + std::to_string(i));
+        want_bulk.append(f.data(), f.size());
+        q.push(std::move(f));
+    }
+    while (!q.empty()) {
+        auto batch = q.gather(iov, 7, 300);
+        std::size_t n = 0;
+        for (auto& b : batch) {
+            const std::size_t take = std::min<std::size_t>(b.size(), 97 - n);
+            got.append(static_cast<const char*>(b.data()), take);
+            n += take;
+            if (n == 97) break;
+        }
+        q.consume(n);
+    }
+    CHECK(got == want_bulk);
+    q.release();
+    CHECK(q.empty() && q.bytes() == 0);
+}
+
+// Pieces of a batch, as bytes
+std::vector<std::string> pieces(const WriteQueue::Batch& batch) {
+    std::vector<std::string> out;
+    for (auto& b : batch) out.emplace_back(static_cast<const char*>(b.data()), b.size());
+    return out;
+}
+
+// Everything still queued, written out in full-sized writes
+std::string drain(WriteQueue& q) {
+    std::vector<boost::asio::const_buffer> iov;
+    std::string out;
+    while (!q.empty()) {
+        std::size_t n = 0;
+        for (auto& piece : pieces(q.gather(iov, WriteQueue::max_iov, 1 << 20))) {
+            out += piece;
+            n += piece.size();
+        }
+        q.consume(n);
+    }
+    return out;
+}
+
+std::string bytes_of(const FrameBuffer& f) {
+    return std::string(f.data(), f.size());
+}
+
+// A keyed frame already handed to the writev is never replaced
+void conflate_skips_in_flight() {
+    WriteQueue q;
+    std::vector<boost::asio::const_buffer> iov;
+    auto v1 = frame(0x10, "v1"), v2 = frame(0x10, "v2");
+    const std::string want = bytes_of(v1) + bytes_of(v2);
+    q.push(std::move(v1), 0, 7);
+    const auto sent = pieces(q.gather(iov, WriteQueue::max_iov, 1 << 20));
+    CHECK(q.push(std::move(v2), 0, 7) == 0);  // appended, not replaced
+    CHECK(q.size() == 2);
+    CHECK(sent.size() == 1 && std::memcmp(iov[0].data(), sent[0].data(), sent[0].size()) == 0);
+    q.consume(sent[0].size());
+    CHECK(sent[0] + drain(q) == want);
+}
+
+// Nor is the partially written head, even once the writev has returned
+void conflate_skips_partial_head() {
+    WriteQueue q;
+    std::vector<boost::asio::const_buffer> iov;
+    auto v1 = frame(0x10, std::string(100, 'a')), v2 = frame(0x10, "v2");
+    const std::string want = bytes_of(v1) + bytes_of(v2);
+    q.push(std::move(v1), 0, 7);
+    const auto sent = pieces(q.gather(iov, WriteQueue::max_iov, 1 << 20));
+    q.consume(10);
+    CHECK(q.push(std::move(v2), 0, 7) == 0);
+    CHECK(q.size() == 2);
+    CHECK(sent[0].substr(0, 10) + drain(q) == want);
+}
+
+// Once its predecessors are written, an unsent keyed frame is replaced in place
+void conflate_after_consume() {
+    WriteQueue q;
+    std::vector<boost::asio::const_buffer> iov;
+    auto head = frame(0x10, "head"), v1 = frame(0x10, "v1-longer"), tail = frame(0x10, "tail"),
+         v2 = frame(0x10, "v2");
+    const std::size_t v1_size = v1.size();
+    const std::string want = bytes_of(v2) + bytes_of(tail);
+    q.push(std::move(head));
+    q.push(std::move(v1), 0, 7);
+    q.push(std::move(tail));
+    const auto sent = pieces(q.gather(iov, 1, 1 << 20));  // only the head goes out
+    CHECK(sent.size() == 1);
+    q.consume(sent[0].size());
+    CHECK(q.push(std::move(v2), 0, 7) == v1_size);
+    CHECK(q.size() == 2);
+    CHECK(drain(q) == want);  // v2 took v1's place ahead of the tail
+}
+
+// bytes() counts exactly what is still to be written through every step
+void conflate_byte_accounting() {
+    WriteQueue q;
+    std::vector<boost::asio::const_buffer> iov;
+    auto a1 = frame(0x10, std::string(40, 'a')), b = frame(0x10, "b"), a2 = frame(0x10, "a2"),
+         a3 = frame(0x10, std::string(60, 'c'));
+    const std::size_t a1_size = a1.size(), b_size = b.size(), a2_size = a2.size(), a3_size = a3.size();
+    q.push(std::move(a1), 0, 9);
+    q.push(std::move(b));
+    CHECK(q.bytes() == a1_size + b_size);
+    CHECK(q.push(std::move(a2), 0, 9) == a1_size);
+    CHECK(q.bytes() == a2_size + b_size);
+    q.gather(iov, WriteQueue::max_iov, 1 << 20);
+    q.consume(3);  // partial a2
+    CHECK(q.bytes() == a2_size + b_size - 3);
+    CHECK(q.push(std::move(a3), 0, 9) == 0);  // a2 is on the wire: appended
+    CHECK(q.bytes() == a2_size + b_size + a3_size - 3);
+    CHECK(drain(q).size() == a2_size + b_size + a3_size - 3);
+    CHECK(q.bytes() == 0);
+}
+
+// Keys conflate within a lane only
+void conflate_per_lane() {
+    WriteQueue q;
+    q.push(frame(0x10, "bulk"), 0, 5);
+    CHECK(q.push(frame(0x11, "ctl"), 0, 5, WriteQueue::control) == 0);
+    CHECK(q.size() == 2);
+}
+
+// Control frames go out ahead of queued bulk ones
+void control_before_bulk() {
+    WriteQueue q;
+    std::vector<boost::asio::const_buffer> iov;
+    auto b1 = frame(0x10, "b1"), b2 = frame(0x10, "b2"), c1 = frame(0x11, "c1");
+    const std::vector<std::string> want{bytes_of(c1), bytes_of(b1), bytes_of(b2)};
+    q.push(std::move(b1));
+    q.push(std::move(b2));
+    q.push(std::move(c1), 0, 0, WriteQueue::control);
+    CHECK(pieces(q.gather(iov, WriteQueue::max_iov, 1 << 20)) == want);
+}
+
+// Only at a frame boundary: a partially written bulk frame finishes first,
+// then control, then the rest of the bulk lane
+void control_waits_for_partial_bulk() {
+    WriteQueue q;
+    std::vector<boost::asio::const_buffer> iov;
+    auto b1 = frame(0x10, std::string(1000, 'b')), b2 = frame(0x10, "b2"), c1 = frame(0x11, "c1");
+    const std::string b1_bytes = bytes_of(b1);
+    const std::vector<std::string> want{b1_bytes.substr(100), bytes_of(c1), bytes_of(b2)};
+    q.push(std::move(b1));
+    q.push(std::move(b2));
+    q.gather(iov, WriteQueue::max_iov, 1 << 20);
+    q.consume(100);
+    q.push(std::move(c1), 0, 0, WriteQueue::control);
+    CHECK(pieces(q.gather(iov, WriteQueue::max_iov, 1 << 20)) == want);
+}
+
+// The same holds for a partially written fragment
+void control_waits_for_partial_fragment() {
+    WriteQueue q;
+    std::vector<boost::asio::const_buffer> iov;
+    auto f1 = frame(0x06, std::string(1000, 'f')), f2 = frame(0x06, "f2"), c1 = frame(0x11, "c1");
+    const std::string f1_bytes = bytes_of(f1);
+    const std::vector<std::string> want{f1_bytes.substr(10), bytes_of(c1), bytes_of(f2)};
+    q.push(std::move(f1), 0, 0, WriteQueue::fragment);
+    q.push(std::move(f2), 0, 0, WriteQueue::fragment);
+    q.gather(iov, WriteQueue::max_iov, 1 << 20);
+    q.consume(10);
+    q.push(std::move(c1), 0, 0, WriteQueue::control);
+    CHECK(pieces(q.gather(iov, WriteQueue::max_iov, 1 << 20)) == want);
+}
+
+// Control, one fragment, all bulk, then the remaining fragments
+void fragments_interleave_with_bulk() {
+    WriteQueue q;
+    std::vector<boost::asio::const_buffer> iov;
+    std::vector<FrameBuffer> f, b;
+    for (int i = 0; i < 3; ++i) f.push_back(frame(0x06, "f" + std::to_string(i)));
+    for (int i = 0; i < 2; ++i) b.push_back(frame(0x10, "b" + std::to_string(i)));
+    auto c = frame(0x11, "c");
+    const std::vector<std::string> want{bytes_of(c),    bytes_of(f[0]), bytes_of(b[0]),
+                                        bytes_of(b[1]), bytes_of(f[1]), bytes_of(f[2])};
+    for (auto& x : f) q.push(std::move(x), 0, 0, WriteQueue::fragment);
+    for (auto& x : b) q.push(std::move(x));
+    q.push(std::move(c), 0, 0, WriteQueue::control);
+    CHECK(pieces(q.gather(iov, WriteQueue::max_iov, 1 << 20)) == want);
+}
+
+// With a small batch the fragment still gets its turn before bulk fills it
+void fragment_not_starved_by_bulk() {
+    WriteQueue q;
+    std::vector<boost::asio::const_buffer> iov;
+    auto f0 = frame(0x06, "f0");
+    const std::string f0_bytes = bytes_of(f0);
+    for (int i = 0; i < 10; ++i) q.push(frame(0x10, "b" + std::to_string(i)));
+    q.push(std::move(f0), 0, 0, WriteQueue::fragment);
+    const auto batch = pieces(q.gather(iov, 2, 1 << 20));
+    CHECK(batch.size() == 2 && batch[0] == f0_bytes);
+}
+
+} // namespace
+
+int main() {
+    push_while_in_flight();
+    addresses_stable_across_growth();
+    drain_in_order();
+    conflate_skips_in_flight();
+    conflate_skips_partial_head();
+    conflate_after_consume();
+    conflate_byte_accounting();
+    conflate_per_lane();
+    control_before_bulk();
+    control_waits_for_partial_bulk();
+    control_waits_for_partial_fragment();
+    fragments_interleave_with_bulk();
+    fragment_not_starved_by_bulk();
+    std::puts("write_queue_test ok");
+    return 0;
+}